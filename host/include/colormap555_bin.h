@@ -0,0 +1,10 @@
+// The host build maps colormap555.bin at run time instead of linking it in
+#ifndef GUARD_HOST_COLORMAP555_BIN_H
+#define GUARD_HOST_COLORMAP555_BIN_H
+
+#include "gba_base.h"
+
+extern const u8 *colormap555_bin;
+extern u32 colormap555_bin_size;
+
+#endif // GUARD_HOST_COLORMAP555_BIN_H
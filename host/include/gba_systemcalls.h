@@ -0,0 +1,37 @@
+// Host implementations of the BIOS calls used by the renderer
+#ifndef GUARD_HOST_GBA_SYSTEMCALLS_H
+#define GUARD_HOST_GBA_SYSTEMCALLS_H
+
+#include "gba_base.h"
+
+#define COPY32 (1 << 26)
+#define FILL   (1 << 24)
+
+static inline void CpuSet(const void *source, void *dest, u32 mode)
+{
+    u32 count = mode & 0x1FFFFF;
+    u32 i;
+
+    if (mode & COPY32)
+    {
+        const u32 *src = source;
+        u32 *dst = dest;
+        for (i = 0; i < count; i++)
+            dst[i] = (mode & FILL) ? src[0] : src[i];
+    }
+    else
+    {
+        const u16 *src = source;
+        u16 *dst = dest;
+        for (i = 0; i < count; i++)
+            dst[i] = (mode & FILL) ? src[0] : src[i];
+    }
+}
+
+static inline void CpuFastSet(const void *source, void *dest, u32 mode)
+{
+    // CpuFastSet always transfers words in blocks of 8
+    CpuSet(source, dest, COPY32 | (mode & FILL) | (((mode & 0x1FFFFF) + 7) & ~7));
+}
+
+#endif // GUARD_HOST_GBA_SYSTEMCALLS_H
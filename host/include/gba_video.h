@@ -0,0 +1,8 @@
+// Minimal stand-in for libgba's gba_video.h used by the host build
+#ifndef GUARD_HOST_GBA_VIDEO_H
+#define GUARD_HOST_GBA_VIDEO_H
+
+#define SCREEN_WIDTH  240
+#define SCREEN_HEIGHT 160
+
+#endif // GUARD_HOST_GBA_VIDEO_H
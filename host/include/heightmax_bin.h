@@ -0,0 +1,10 @@
+// The host build maps heightmax.bin at run time instead of linking it in
+#ifndef GUARD_HOST_HEIGHTMAX_BIN_H
+#define GUARD_HOST_HEIGHTMAX_BIN_H
+
+#include "gba_base.h"
+
+extern const u8 *heightmax_bin;
+extern u32 heightmax_bin_size;
+
+#endif // GUARD_HOST_HEIGHTMAX_BIN_H
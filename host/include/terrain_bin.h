@@ -0,0 +1,10 @@
+// The host build maps terrain.bin at run time instead of linking it in
+#ifndef GUARD_HOST_TERRAIN_BIN_H
+#define GUARD_HOST_TERRAIN_BIN_H
+
+#include "gba_base.h"
+
+extern const u8 *terrain_bin;
+extern u32 terrain_bin_size;
+
+#endif // GUARD_HOST_TERRAIN_BIN_H
@@ -0,0 +1,10 @@
+// The host build maps terrainmip.bin at run time instead of linking it in
+#ifndef GUARD_HOST_TERRAINMIP_BIN_H
+#define GUARD_HOST_TERRAINMIP_BIN_H
+
+#include "gba_base.h"
+
+extern const u8 *terrainmip_bin;
+extern u32 terrainmip_bin_size;
+
+#endif // GUARD_HOST_TERRAINMIP_BIN_H
@@ -0,0 +1,339 @@
+// Host-side test harness for the voxel renderer
+//
+// Renders a fixed set of camera poses with render_c into a fake 240x160 8bpp
+// frame buffer and compares a CRC of each frame against golden values. Every
+// pose is rendered with the default quality preset at full resolution, and the
+// first pose also with each of the other presets and resolutions (named
+// "<pose>@<preset>" and "<pose>@<resolution>") and interlaced (named
+// "<pose>@interlaced", which must match the full frame), split for the ground
+// plane of HYBRID builds at their resolution (named "<pose>@plane"), with the
+// far field projected from the skyline of SKYLINE builds (named
+// "<pose>@skyline"), and with the Mode 5 renderer into a 160x128 true-color
+// page (named "<pose>@mode5").
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <gba_video.h>
+
+#include "colormap555_bin.h"
+#include "heightmax_bin.h"
+#include "hybrid.h"
+#include "poses.h"
+#include "render.h"
+#include "terrain_bin.h"
+#include "terrainmip_bin.h"
+
+#define FRAME_SIZE (SCREEN_WIDTH * SCREEN_HEIGHT)
+
+const u8 *terrain_bin;
+u32 terrain_bin_size;
+const u8 *heightmax_bin;
+u32 heightmax_bin_size;
+const u8 *terrainmip_bin;
+u32 terrainmip_bin_size;
+const u8 *colormap555_bin;
+u32 colormap555_bin_size;
+
+struct Camera camera;
+u16 *frameBuffer;
+
+void swap_buffers(void)
+{
+}
+
+static u16 sFrame[FRAME_SIZE / 2];
+static u16 sPrevFrame[FRAME_SIZE / 2];
+static u16 sMode5Frame[MODE5_WIDTH * MODE5_HEIGHT];
+
+static const u8 *load_file(const char *filename, u32 *size)
+{
+    struct stat st;
+    const u8 *data;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(filename);
+        exit(1);
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        perror(filename);
+        exit(1);
+    }
+    *size = st.st_size;
+    close(fd);
+    return data;
+}
+
+static u32 crc32(const void *data, size_t size)
+{
+    const u8 *p = data;
+    u32 crc = 0xFFFFFFFF;
+    size_t i;
+    int j;
+
+    for (i = 0; i < size; i++)
+    {
+        crc ^= p[i];
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+// Writes a Mode 4 frame as a PGM of its palette indices, and a Mode 5 frame
+// as a PPM
+static void dump_frame(const char *dir, const char *name, const u16 *frame)
+{
+    char filename[256];
+    FILE *f;
+    int i;
+
+    snprintf(filename, sizeof(filename), "%s/%s.%s", dir, name, frame == sMode5Frame ? "ppm" : "pgm");
+    f = fopen(filename, "wb");
+    if (f == NULL)
+    {
+        perror(filename);
+        exit(1);
+    }
+    if (frame == sMode5Frame)
+    {
+        fprintf(f, "P6\n%i %i\n31\n", MODE5_WIDTH, MODE5_HEIGHT);
+        for (i = 0; i < MODE5_WIDTH * MODE5_HEIGHT; i++)
+        {
+            fputc(frame[i] & 31, f);
+            fputc((frame[i] >> 5) & 31, f);
+            fputc((frame[i] >> 10) & 31, f);
+        }
+    }
+    else
+    {
+        fprintf(f, "P5\n%i %i\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+        fwrite(frame, 1, FRAME_SIZE, f);
+    }
+    fclose(f);
+}
+
+// Returns nonzero and sets *crc if a golden value for the pose exists
+static int find_golden(const char *goldenFile, const char *name, u32 *crc)
+{
+    char line[256];
+    char lineName[64];
+    unsigned int value;
+    FILE *f = fopen(goldenFile, "r");
+
+    if (f == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%63s %x", lineName, &value) == 2 && strcmp(lineName, name) == 0)
+        {
+            fclose(f);
+            *crc = value;
+            return 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+// Compares a frame (sFrame or sMode5Frame) against its golden value, or
+// writes the value to update. Returns nonzero on a mismatch.
+static int check_frame(const char *name, const u16 *frame, const char *goldenFile, FILE *update, const char *dumpDir)
+{
+    u32 crc = crc32(frame, frame == sMode5Frame ? sizeof(sMode5Frame) : FRAME_SIZE);
+    u32 golden;
+
+    if (dumpDir != NULL)
+        dump_frame(dumpDir, name, frame);
+
+    if (update != NULL)
+    {
+        fprintf(update, "%-17s 0x%08X\n", name, crc);
+        return 0;
+    }
+    if (!find_golden(goldenFile, name, &golden))
+    {
+        printf("FAIL %-17s no golden value\n", name);
+        return 1;
+    }
+    if (crc != golden)
+    {
+        printf("FAIL %-17s got 0x%08X, expected 0x%08X\n", name, crc, golden);
+        return 1;
+    }
+    printf("ok   %s\n", name);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [-u] [-d dumpdir] terrain.bin heightmax.bin terrainmip.bin colormap555.bin golden.txt\n"
+        "  -u  rewrite golden.txt from the current renderer output\n"
+        "  -d  write each rendered pose to dumpdir/<pose>.pgm (.ppm for Mode 5)\n",
+        prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dumpDir = NULL;
+    const char *goldenFile;
+    FILE *update = NULL;
+    int failures = 0;
+    int opt;
+    int quality;
+    unsigned int i;
+
+    while ((opt = getopt(argc, argv, "ud:")) != -1)
+    {
+        if (opt == 'u')
+            update = stdout;
+        else if (opt == 'd')
+            dumpDir = optarg;
+        else
+            usage(argv[0]);
+    }
+    if (argc - optind != 5)
+        usage(argv[0]);
+
+    terrain_bin = load_file(argv[optind], &terrain_bin_size);
+    heightmax_bin = load_file(argv[optind + 1], &heightmax_bin_size);
+    terrainmip_bin = load_file(argv[optind + 2], &terrainmip_bin_size);
+    colormap555_bin = load_file(argv[optind + 3], &colormap555_bin_size);
+    goldenFile = argv[optind + 4];
+    if (update != NULL)
+    {
+        update = fopen(goldenFile, "w");
+        if (update == NULL)
+        {
+            perror(goldenFile);
+            return 1;
+        }
+        fprintf(update, "# pose            crc32 of the frame rendered by render_c (render_mode5_c for @mode5)\n");
+    }
+
+    render_init();
+    frameBuffer = sFrame;
+
+    for (quality = 0; quality < QUALITY_PRESET_COUNT; quality++)
+    {
+        render_set_quality(quality);
+        for (i = 0; i < gPoseCount; i++)
+        {
+            const struct Pose *pose = &gPoses[i];
+            char name[64];
+
+            if (quality == QUALITY_DEFAULT)
+                snprintf(name, sizeof(name), "%s", pose->name);
+            else if (i == 0)
+                snprintf(name, sizeof(name), "%s@%s", pose->name, gQualityPresets[quality].name);
+            else
+                break;
+
+            // the renderer must write every pixel, so don't let the previous
+            // frame hide any it misses
+            memset(sFrame, 0xEE, sizeof(sFrame));
+            set_camera_pose(pose);
+            render_c(SCREEN_WIDTH/2, SCREEN_HEIGHT);
+            failures += check_frame(name, sFrame, goldenFile, update, dumpDir);
+        }
+    }
+
+    // the lower resolutions leave the rest of the page alone
+    render_set_quality(QUALITY_DEFAULT);
+    for (i = 0; i < RESOLUTION_COUNT; i++)
+    {
+        char name[64];
+
+        if (i == RESOLUTION_FULL)
+            continue;
+        snprintf(name, sizeof(name), "%s@%s", gPoses[0].name, gResolutions[i].name);
+        memset(sFrame, 0xEE, sizeof(sFrame));
+        set_camera_pose(&gPoses[0]);
+        render_c(gResolutions[i].columns, gResolutions[i].rows);
+        failures += check_frame(name, sFrame, goldenFile, update, dumpDir);
+    }
+
+    // Two fields of a still camera make up the full frame: render the even
+    // field into the previous page and the odd one into the current page,
+    // then copy the even field over like main.c does
+    {
+        char name[64];
+
+        set_camera_pose(&gPoses[0]);
+        renderInterlaced = 1;
+        memset(sPrevFrame, 0xEE, sizeof(sPrevFrame));
+        frameBuffer = sPrevFrame;
+        renderField = 0;
+        render_c(SCREEN_WIDTH/2, SCREEN_HEIGHT);
+        memset(sFrame, 0xEE, sizeof(sFrame));
+        frameBuffer = sFrame;
+        renderField = 1;
+        render_c(SCREEN_WIDTH/2, SCREEN_HEIGHT);
+        copy_field_c(sFrame, sPrevFrame, 0);
+        renderInterlaced = 0;
+        snprintf(name, sizeof(name), "%s@interlaced", gPoses[0].name);
+        failures += check_frame(name, sFrame, goldenFile, update, dumpDir);
+    }
+
+    // the ground plane split of HYBRID builds leaves the rows above the
+    // near terrain alone
+    {
+        char name[64];
+
+        set_camera_pose(&gPoses[0]);
+        renderPlaneZ = HYBRID_PLANE_Z;
+        memset(sFrame, 0xEE, sizeof(sFrame));
+        render_c(gResolutions[HYBRID_RESOLUTION].columns, gResolutions[HYBRID_RESOLUTION].rows);
+        renderPlaneZ = 0;
+        snprintf(name, sizeof(name), "%s@plane", gPoses[0].name);
+        failures += check_frame(name, sFrame, goldenFile, update, dumpDir);
+    }
+
+    // the skyline of SKYLINE builds, built for the pose
+    {
+        char name[64];
+
+        set_camera_pose(&gPoses[0]);
+        renderSkylineZ = SKYLINE_Z;
+        render_build_skyline();
+        memset(sFrame, 0xEE, sizeof(sFrame));
+        render_c(SCREEN_WIDTH/2, SCREEN_HEIGHT);
+        renderSkylineZ = 0;
+        snprintf(name, sizeof(name), "%s@skyline", gPoses[0].name);
+        failures += check_frame(name, sFrame, goldenFile, update, dumpDir);
+    }
+
+    // the sky of the Mode 5 page is not in the palette, so any color does
+    {
+        char name[64];
+
+        set_camera_pose(&gPoses[0]);
+        mode5SkyColor = 0x7E8C;
+        memset(sMode5Frame, 0xEE, sizeof(sMode5Frame));
+        frameBuffer = sMode5Frame;
+        render_mode5_c();
+        frameBuffer = sFrame;
+        snprintf(name, sizeof(name), "%s@mode5", gPoses[0].name);
+        failures += check_frame(name, sMode5Frame, goldenFile, update, dumpDir);
+    }
+
+    if (update != NULL)
+    {
+        fclose(update);
+        return 0;
+    }
+    return failures != 0;
+}
@@ -0,0 +1,162 @@
+#include <gba_base.h>
+#include <gba_video.h>
+
+#include "bench.h"
+#include "debug.h"
+#include "hybrid.h"
+#include "io_reg.h"
+#include "poses.h"
+#include "render.h"
+#include "timer.h"
+
+#ifdef BENCHMARK
+
+// Number of times each renderer draws each pose
+#define BENCH_RUNS 9
+
+struct BenchRenderer
+{
+    const char *name;
+    void (*render)(u32 columns, u32 rows);
+};
+
+// One frame of interlaced rendering: a field, then the other field copied in.
+// main.c copies from the page on screen, this copies the back buffer onto
+// itself, which takes as long.
+static void render_asm_interlaced(u32 columns, u32 rows)
+{
+    renderInterlaced = 1;
+    render_asm(columns, rows);
+    copy_field_asm(frameBuffer, frameBuffer, renderField ^ 1);
+    renderField ^= 1;
+    renderInterlaced = 0;
+}
+
+static void render_asm_spans(u32 columns, u32 rows)
+{
+    renderSpanList = 1;
+    render_asm(columns, rows);
+    renderSpanList = 0;
+}
+
+static void render_asm_strips(u32 columns, u32 rows)
+{
+    renderColumnStrips = 1;
+    render_asm(columns, rows);
+    renderColumnStrips = 0;
+}
+
+// The voxels of a HYBRID build, without the ground plane (see hybrid.h)
+static void render_asm_plane(u32 columns, u32 rows)
+{
+    renderPlaneZ = HYBRID_PLANE_Z;
+    render_asm(columns, rows);
+    renderPlaneZ = 0;
+}
+
+// The voxels of a SKYLINE build, with the skyline built for the pose (see
+// bench_run) and the part of it a SKYLINE build rebuilds every frame, which
+// main times with the renderer
+static void render_asm_skyline(u32 columns, u32 rows)
+{
+    renderSkylineZ = SKYLINE_Z;
+    render_update_skyline(SKYLINE_UPDATE_DIRECTIONS, SKYLINE_BACKGROUND_DIRECTIONS);
+    render_asm(columns, rows);
+    renderSkylineZ = 0;
+}
+
+static const struct BenchRenderer sRenderers[] =
+{
+    {"render_asm", render_asm},
+    {"render_c",   render_c},
+    {"render_asm_interlaced", render_asm_interlaced},
+    {"render_asm_spans", render_asm_spans},
+    {"render_asm_strips", render_asm_strips},
+    {"render_asm_plane", render_asm_plane},
+    {"render_asm_skyline", render_asm_skyline},
+};
+
+struct BenchWaitStates
+{
+    const char *name;
+    u16 waitcnt;
+};
+
+// The renderers run from IWRAM, so the difference between these settings is
+// almost entirely the wait cycles of their terrain reads from ROM
+static const struct BenchWaitStates sWaitStates[] =
+{
+    {"4/2",          0},
+    {"3/1+prefetch", WAITCNT_FAST},
+};
+
+static void sort_times(u32 *times, int count)
+{
+    int i, j;
+
+    for (i = 1; i < count; i++)
+    {
+        u32 t = times[i];
+        for (j = i; j > 0 && times[j - 1] > t; j--)
+            times[j] = times[j - 1];
+        times[j] = t;
+    }
+}
+
+// Renders every pose in gPoses with every renderer at every internal
+// resolution and reports min/median/max cycle counts as CSV through the
+// debug log
+void bench_run(void)
+{
+    u32 times[BENCH_RUNS];
+    unsigned int i, j, k, r;
+    int run;
+
+    debug_init();
+    debug_printf("# gba-3d-bench: %i runs per pose", BENCH_RUNS);
+    debug_printf("pose,renderer,resolution,waitcnt,min,median,max");
+
+    for (i = 0; i < gPoseCount; i++)
+    {
+        for (j = 0; j < sizeof(sRenderers) / sizeof(sRenderers[0]); j++)
+        {
+            for (r = 0; r < RESOLUTION_COUNT; r++)
+            {
+                const struct Resolution *res = &gResolutions[r];
+
+                // paired mode is never interlaced and has no other back ends
+                if ((sRenderers[j].render == render_asm_interlaced || sRenderers[j].render == render_asm_spans
+                  || sRenderers[j].render == render_asm_strips || sRenderers[j].render == render_asm_skyline)
+                 && res->columns == SCREEN_WIDTH)
+                    continue;
+                for (k = 0; k < sizeof(sWaitStates) / sizeof(sWaitStates[0]); k++)
+                {
+                    REG_WAITCNT = sWaitStates[k].waitcnt;
+                    set_camera_pose(&gPoses[i]);
+                    // untimed, like a camera that has stood still for a while
+                    if (sRenderers[j].render == render_asm_skyline)
+                    {
+                        renderSkylineZ = SKYLINE_Z;
+                        render_build_skyline();
+                        renderSkylineZ = 0;
+                    }
+                    for (run = 0; run < BENCH_RUNS; run++)
+                    {
+                        start_timer();
+                        sRenderers[j].render(res->columns, res->rows);
+                        times[run] = stop_timer();
+                    }
+                    swap_buffers();
+                    sort_times(times, BENCH_RUNS);
+                    debug_printf("%s,%s,%s,%s,%lu,%lu,%lu", gPoses[i].name, sRenderers[j].name, res->name,
+                        sWaitStates[k].name, times[0], times[BENCH_RUNS / 2], times[BENCH_RUNS - 1]);
+                }
+            }
+        }
+    }
+
+    REG_WAITCNT = WAITCNT_FAST;
+    debug_printf("# done");
+}
+
+#endif // BENCHMARK
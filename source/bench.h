@@ -0,0 +1,6 @@
+#ifndef GUARD_BENCH_H
+#define GUARD_BENCH_H
+
+void bench_run(void);
+
+#endif // GUARD_BENCH_H
@@ -0,0 +1,57 @@
+#include <gba_base.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "debug.h"
+
+// mGBA debug registers
+#define REG_DEBUG_ENABLE (*(vu16 *)0x4FFF780)
+#define REG_DEBUG_FLAGS  (*(vu16 *)0x4FFF700)
+#define REG_DEBUG_STRING ((char *)0x4FFF600)
+
+#define DEBUG_LEVEL_INFO 3
+#define DEBUG_FLAG_SEND  0x100
+
+#define SRAM_LOG ((vu8 *)0x0E000000)
+#define SRAM_LOG_SIZE 0x6000  // the rest holds the input recording (see replay.c)
+
+// Emulators look for this string to decide which save type to emulate
+__attribute__((used)) static const char sSaveTypeTag[] ALIGN(4) = "SRAM_V113";
+
+static int sMgbaPresent = 0;
+static unsigned int sSramPos = 0;
+
+void debug_init(void)
+{
+    REG_DEBUG_ENABLE = 0xC0DE;
+    sMgbaPresent = (REG_DEBUG_ENABLE == 0x1DEA);
+    sSramPos = 0;
+    SRAM_LOG[0] = 0;
+}
+
+void debug_printf(const char *fmt, ...)
+{
+    char buffer[256];
+    va_list args;
+    int i;
+
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    if (sMgbaPresent)
+    {
+        for (i = 0; buffer[i] != 0; i++)
+            REG_DEBUG_STRING[i] = buffer[i];
+        REG_DEBUG_STRING[i] = 0;
+        REG_DEBUG_FLAGS = DEBUG_LEVEL_INFO | DEBUG_FLAG_SEND;
+    }
+
+    // SRAM is on an 8-bit bus, so it must be written one byte at a time.
+    // The log is kept NUL-terminated so a partial run can still be read.
+    for (i = 0; buffer[i] != 0 && sSramPos < SRAM_LOG_SIZE - 2; i++)
+        SRAM_LOG[sSramPos++] = buffer[i];
+    if (sSramPos < SRAM_LOG_SIZE - 1)
+        SRAM_LOG[sSramPos++] = '\n';
+    SRAM_LOG[sSramPos] = 0;
+}
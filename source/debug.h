@@ -0,0 +1,11 @@
+#ifndef GUARD_DEBUG_H
+#define GUARD_DEBUG_H
+
+// Machine-readable output for headless runs. Every line goes to the mGBA
+// debug log (when running under mGBA) and is appended to a text log in SRAM,
+// which emulators save as the .sav file.
+
+void debug_init(void);
+void debug_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif // GUARD_DEBUG_H
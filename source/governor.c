@@ -0,0 +1,124 @@
+#include <gba_base.h>
+#include <stddef.h>
+
+#include "governor.h"
+#include "render.h"
+
+int governorEnabled;
+
+// Levels of the ladder: the quality presets at RESOLUTION_FULL, then each
+// lower resolution with the fastest preset
+#define LEVEL_COUNT (QUALITY_PRESET_COUNT + RESOLUTION_COUNT - 1 - RESOLUTION_FULL)
+
+static u32 sTargetCycles;
+static int *sResolution;
+static int sOverFrames;   // consecutive frames over the budget
+static int sUnderFrames;  // consecutive frames the next slower level would have fit
+static int sLastLevel;    // level of the last frame, -1 if none yet
+static u32 sLastTime;     // and its render time
+// Render time of level - 1 over that of level (8.8 fixed point), measured on
+// the two frames around the last step between them, 0 if never seen
+static u32 sSlowerRatio[LEVEL_COUNT];
+
+void governor_init(u32 targetCycles, int *resolution)
+{
+    int i;
+
+    sTargetCycles = targetCycles;
+    sResolution = resolution;
+    sOverFrames = 0;
+    sUnderFrames = 0;
+    sLastLevel = -1;
+    for (i = 0; i < LEVEL_COUNT; i++)
+        sSlowerRatio[i] = 0;
+    governorEnabled = 1;
+}
+
+// Returns the level of the current quality and resolution. Paired mode is
+// off the ladder, and counts as the level of its preset at RESOLUTION_FULL.
+static int current_level(void)
+{
+    if (sResolution == NULL || *sResolution <= RESOLUTION_FULL)
+        return renderQuality;
+    return QUALITY_PRESET_COUNT - 1 + *sResolution - RESOLUTION_FULL;
+}
+
+static int level_count(void)
+{
+    return sResolution == NULL ? QUALITY_PRESET_COUNT : LEVEL_COUNT;
+}
+
+static void set_level(int level)
+{
+    if (level < QUALITY_PRESET_COUNT)
+    {
+        render_set_quality(level);
+        if (sResolution != NULL)
+            *sResolution = RESOLUTION_FULL;
+    }
+    else
+    {
+        render_set_quality(QUALITY_PRESET_COUNT - 1);
+        *sResolution = RESOLUTION_FULL + level - (QUALITY_PRESET_COUNT - 1);
+    }
+}
+
+// Returns the render time the next slower level would take for a frame that
+// took renderTime at the current one. Levels cost about the same relative to
+// each other in every view, so scale by the ratio seen when the governor last
+// stepped between the two, or assume twice the time if it never has.
+static u32 predict_slower(int level, u32 renderTime)
+{
+    if (sSlowerRatio[level] == 0)
+        return renderTime * 2;
+    return (renderTime >> 8) * sSlowerRatio[level];
+}
+
+// Measures the ratio between the last two levels if they are neighbors. The
+// camera barely moves between two frames, so they show about the same view.
+static void update_ratio(int level, u32 renderTime)
+{
+    if (sLastLevel == level + 1 && sLastTime != 0)
+        sSlowerRatio[sLastLevel] = (renderTime << 8) / sLastTime;
+    else if (sLastLevel == level - 1 && renderTime != 0)
+        sSlowerRatio[level] = (sLastTime << 8) / renderTime;
+    sLastLevel = level;
+    sLastTime = renderTime;
+}
+
+// Must be called once per frame with the render time of the frame
+void governor_update(u32 renderTime)
+{
+    int level;
+
+    if (!governorEnabled)
+        return;
+    level = current_level();
+    update_ratio(level, renderTime);
+
+    if (renderTime > sTargetCycles)
+    {
+        sUnderFrames = 0;
+        if (++sOverFrames >= GOVERNOR_DROP_FRAMES && level < level_count() - 1)
+        {
+            set_level(level + 1);
+            sOverFrames = 0;
+        }
+        return;
+    }
+    sOverFrames = 0;
+
+    if (level > 0
+     && predict_slower(level, renderTime) < sTargetCycles / 100 * (100 - GOVERNOR_RAISE_MARGIN))
+    {
+        if (++sUnderFrames >= GOVERNOR_RAISE_FRAMES)
+        {
+            set_level(level - 1);
+            sUnderFrames = 0;
+        }
+    }
+    else
+    {
+        sUnderFrames = 0;
+    }
+}
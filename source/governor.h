@@ -0,0 +1,33 @@
+#ifndef GUARD_GOVERNOR_H
+#define GUARD_GOVERNOR_H
+
+// Quality governor: picks the quality preset (see render_set_quality) and
+// the internal resolution (see gResolutions) from the render time of each
+// frame so that rendering fits a cycle budget. It steps through a ladder of
+// levels, each quality preset at 120x160 and then the lower resolutions with
+// the fastest preset. It drops to a faster level after GOVERNOR_DROP_FRAMES
+// consecutive frames over the budget, and only moves back to a slower one
+// after GOVERNOR_RAISE_FRAMES consecutive frames in which that level is
+// predicted to fit with GOVERNOR_RAISE_MARGIN to spare, so the quality does
+// not flicker between two levels.
+
+#include <gba_base.h>
+
+#define CYCLES_PER_FRAME 280896  // 228 lines of 1232 cycles
+
+// Render budget for 30 fps, leaving an eighth of the two frames for the rest
+// of the main loop
+#define GOVERNOR_TARGET_30FPS (2 * CYCLES_PER_FRAME * 7 / 8)
+
+#define GOVERNOR_DROP_FRAMES  2
+#define GOVERNOR_RAISE_FRAMES 30
+#define GOVERNOR_RAISE_MARGIN 8  // percent of the budget
+
+extern int governorEnabled;
+
+// resolution is the internal resolution the frames are rendered at, which
+// the governor steps too, or NULL in builds that render at only one
+void governor_init(u32 targetCycles, int *resolution);
+void governor_update(u32 renderTime);
+
+#endif // GUARD_GOVERNOR_H
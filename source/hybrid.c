@@ -0,0 +1,201 @@
+#include <gba_base.h>
+#include <gba_interrupt.h>
+#include <gba_systemcalls.h>
+#include <gba_video.h>
+
+#include "io_reg.h"
+#include "macro.h"
+#include "hybrid.h"
+#include "render.h"
+
+#include "terrainmip_bin.h"
+
+// DMA0 loads the line tables (io_reg.h leaves the register definitions to
+// libgba, whose gba_dma.h flags clash with its own)
+#define REG_LINE_DMA_SAD   (*(vu32 *)REG_ADDR_DMA0SAD)
+#define REG_LINE_DMA_DAD   (*(vu32 *)REG_ADDR_DMA0DAD)
+#define REG_LINE_DMA_CNT_L (*(vu16 *)REG_ADDR_DMA0CNT_L)
+#define REG_LINE_DMA_CNT_H (*(vu16 *)REG_ADDR_DMA0CNT_H)
+
+// The ground texture sits in the bottom right corner of the page, clear of
+// the HYBRID_RESOLUTION frame. The ground plane reaches up to
+// MAX_DRAW_DISTANCE * sqrt(2) texels (23 cells) away from the camera at the
+// corners of the screen, 7 cells past the texture on the top and left, where
+// an 8 pixel border of color 0 (the backdrop, which is the sky) keeps it from
+// picking up the frame. Past the bottom and right it is outside the page,
+// which shows the backdrop too.
+#define GROUND_SIZE   32  // pixels
+#define GROUND_SHIFT  5   // log2 of the texels per pixel (TERRAIN_PITCH / GROUND_SIZE)
+#define GROUND_LEFT   (SCREEN_WIDTH - GROUND_SIZE)
+#define GROUND_TOP    (SCREEN_HEIGHT - GROUND_SIZE)
+
+// last mip level, which has a texel per 2^GROUND_MIP x 2^GROUND_MIP texels
+#define GROUND_MIP    TERRAIN_MIP_LEVELS
+#define GROUND_MIP_SIZE (TERRAIN_PITCH >> GROUND_MIP)
+
+// Line tables: the one being shown, and the one being built for the back
+// buffer. Entry y is loaded during the h-blank before line y, and entry 0 by
+// the v-blank handler. The last entry is loaded after the last line.
+static EWRAM_BSS struct BgAffineLine sLines[2][SCREEN_HEIGHT + 1];
+static int sShownLines;
+
+static s32 sPlaneHeight;
+// cell at the top left of the ground texture in each page (the one at VRAM
+// is page 1, like fbNum)
+static s32 sPageOriginX[2];
+static s32 sPageOriginY[2];
+
+static const u8 *ground_texel(u32 cellX, u32 cellY)
+{
+    u32 x = (cellX << (GROUND_SHIFT - GROUND_MIP)) + (1 << (GROUND_SHIFT - GROUND_MIP - 1));
+    u32 y = (cellY << (GROUND_SHIFT - GROUND_MIP)) + (1 << (GROUND_SHIFT - GROUND_MIP - 1));
+
+    return terrainmip_bin + (y * TERRAIN_PITCH + TERRAIN_PITCH - (2 * TERRAIN_PITCH >> GROUND_MIP) + x) * 2;
+}
+
+// Starts the DMA over at the top of the shown table. Must be called during
+// v-blank.
+static void rearm_line_dma(void)
+{
+    const struct BgAffineLine *lines = sLines[sShownLines];
+
+    REG_LINE_DMA_CNT_H = 0;
+    REG_BG2PA = lines[0].pa;
+    REG_BG2PB = lines[0].pb;
+    REG_BG2PC = lines[0].pc;
+    REG_BG2PD = lines[0].pd;
+    REG_BG2X = lines[0].x;
+    REG_BG2Y = lines[0].y;
+    REG_LINE_DMA_SAD = (u32)&lines[1];
+    REG_LINE_DMA_DAD = REG_ADDR_BG2PA;
+    REG_LINE_DMA_CNT_L = sizeof(struct BgAffineLine) / 4;
+    REG_LINE_DMA_CNT_H = DMA_ENABLE | DMA_START_HBLANK | DMA_REPEAT | DMA_32BIT | DMA_DEST_RELOAD;
+}
+
+static void hybrid_vblank(void)
+{
+    rearm_line_dma();
+}
+
+// Fills a line table with the stretch of a frame of the given size, with no
+// ground plane
+static void build_stretch_lines(struct BgAffineLine *lines, u32 columns, u32 rows)
+{
+    s32 columnScale = RENDER_COLUMN_SCALE(columns);
+    s32 rowScale = RENDER_ROW_SCALE(rows);
+    int y;
+
+    for (y = 0; y <= SCREEN_HEIGHT; y++)
+    {
+        lines[y].pa = columnScale;
+        lines[y].pb = 0;
+        lines[y].pc = 0;
+        lines[y].pd = rowScale;
+        lines[y].x = 0;
+        lines[y].y = y * rowScale;
+    }
+}
+
+void hybrid_init(void)
+{
+    u32 sum = 0;
+    u32 x, y;
+
+    // the border, and the rest of both pages until they are drawn
+    CpuFastFill(0, (void *)VRAM, 2 * 0xA000);
+    for (y = 0; y < GROUND_MIP_SIZE; y++)
+    {
+        const u8 *texel = terrainmip_bin + (y * TERRAIN_PITCH + TERRAIN_PITCH - (2 * TERRAIN_PITCH >> GROUND_MIP)) * 2;
+
+        for (x = 0; x < GROUND_MIP_SIZE; x++)
+            sum += texel[x * 2 + 1];
+    }
+    sPlaneHeight = sum / (GROUND_MIP_SIZE * GROUND_MIP_SIZE);
+    // no texture is drawn in either page yet
+    sPageOriginX[0] = sPageOriginX[1] = -1;
+    sPageOriginY[0] = sPageOriginY[1] = -1;
+
+    build_stretch_lines(sLines[0], gResolutions[HYBRID_RESOLUTION].columns, gResolutions[HYBRID_RESOLUTION].rows);
+    sShownLines = 0;
+    renderPlaneZ = HYBRID_PLANE_Z;
+    irqSet(IRQ_VBLANK, hybrid_vblank);
+    irqEnable(IRQ_VBLANK);
+}
+
+// Draws the ground texture centered on the camera into frameBuffer, unless
+// the page already holds it
+static void draw_ground(s32 originX, s32 originY)
+{
+    int page = (frameBuffer == (u16 *)VRAM);
+    u32 x, y;
+
+    if (originX == sPageOriginX[page] && originY == sPageOriginY[page])
+        return;
+    sPageOriginX[page] = originX;
+    sPageOriginY[page] = originY;
+    for (y = 0; y < GROUND_SIZE; y++)
+    {
+        u32 cellY = (originY + y) & (GROUND_SIZE - 1);
+        u16 *dest = frameBuffer + (GROUND_TOP + y) * SCREEN_WIDTH/2 + GROUND_LEFT/2;
+
+        for (x = 0; x < GROUND_SIZE; x += 2)
+        {
+            u32 left = *ground_texel((originX + x) & (GROUND_SIZE - 1), cellY);
+            u32 right = *ground_texel((originX + x + 1) & (GROUND_SIZE - 1), cellY);
+
+            *dest++ = left | (right << 8);
+        }
+    }
+}
+
+void hybrid_update_page(u32 columns, u32 rows)
+{
+    struct BgAffineLine *lines = sLines[sShownLines ^ 1];
+    s32 rowScale = RENDER_ROW_SCALE(rows);
+    s32 dh = camera.height - sPlaneHeight;
+    fixed_t s = camera.sinYaw;
+    fixed_t c = camera.cosYaw;
+    // cell at the top left of the texture, and the camera relative to it
+    s32 originX = (camera.x >> (16 + GROUND_SHIFT)) - GROUND_SIZE/2;
+    s32 originY = (camera.y >> (16 + GROUND_SHIFT)) - GROUND_SIZE/2;
+    fixed_t relX = camera.x - originX * (1 << (16 + GROUND_SHIFT));
+    fixed_t relY = camera.y - originY * (1 << (16 + GROUND_SHIFT));
+    int y;
+
+    draw_ground(originX, originY);
+    build_stretch_lines(lines, columns, rows);
+    // Line y shows rendered row y * rowScale >> 8, like the stretch. Above
+    // renderPlaneRow, it shows the ground plane at the z where the renderers
+    // would put it (a slice at z puts height h on line
+    // (camera.height - h) * 128 / z + camera.horizon), sampled along the
+    // slice the way the renderers spread 2z texels across 256 pixels.
+    for (y = 0; y < SCREEN_HEIGHT && (u32)((y * rowScale) >> 8) < (u32)renderPlaneRow; y++)
+    {
+        s32 dy = y - camera.horizon;
+        s32 z;
+
+        lines[y].pd = 0;
+        // the sky, past the draw distance or beyond the horizon
+        if (dy == 0 || (dy < 0) != (dh < 0)
+         || (z = dh * 128 / dy) > MAX_DRAW_DISTANCE)
+        {
+            lines[y].pa = 0;
+            lines[y].x = SCREEN_WIDTH << 8;
+            continue;
+        }
+        // 8.8 texture pixels per screen pixel: z * c / 128 texels
+        lines[y].pa = (z * c) >> (7 + GROUND_SHIFT + 8);
+        lines[y].pc = -(z * s) >> (7 + GROUND_SHIFT + 8);
+        lines[y].x = (GROUND_LEFT << 8) + ((relX + (-c - s) * z) >> (GROUND_SHIFT + 8));
+        lines[y].y = (GROUND_TOP << 8) + ((relY + (s - c) * z) >> (GROUND_SHIFT + 8));
+    }
+}
+
+void hybrid_present(void)
+{
+    // don't let the v-blank handler rearm the DMA halfway through
+    REG_IME = 0;
+    sShownLines ^= 1;
+    rearm_line_dma();
+    REG_IME = 1;
+}
@@ -0,0 +1,45 @@
+#ifndef GUARD_HYBRID_H
+#define GUARD_HYBRID_H
+
+// Hybrid rendering (HYBRID builds, make hybrid): render_asm only draws the
+// voxels up to the ground plane split (see renderPlaneZ), and BG2 draws the
+// far field above it as a flat ground plane, Mode 7 style. Mode 4 has no
+// second affine background, so the plane and the rendered page share BG2
+// line by line: an HBlank DMA loads each line's affine parameters from a
+// table, which stretches the page like present_rendered_page on the lines
+// from renderPlaneRow down, and projects the ground texture on the lines
+// above it.
+//
+// The ground texture is a 32x32 pixel picture of the whole map, a pixel per
+// 32x32 texel cell point sampled from the last terrain mip level, in the
+// corner of each page that the HYBRID_RESOLUTION frame leaves unused. It is
+// scrolled to keep the camera at its center, and the plane lies at the mean
+// height of the terrain.
+
+#include <gba_base.h>
+
+#include "render.h"
+
+#define HYBRID_RESOLUTION RESOLUTION_HALF_AREA
+#define HYBRID_PLANE_Z 256
+
+// The layout of this struct must match the BG2PA..BG2Y registers
+struct BgAffineLine
+{
+    /*0x00*/ s16 pa;
+    /*0x02*/ s16 pb;
+    /*0x04*/ s16 pc;
+    /*0x06*/ s16 pd;
+    /*0x08*/ s32 x;
+    /*0x0C*/ s32 y;
+};
+
+// Clears both pages and starts the v-blank handler that rearms the DMA
+void hybrid_init(void);
+// Draws the ground texture into frameBuffer and builds its line table for
+// the frame just rendered there with the current camera
+void hybrid_update_page(u32 columns, u32 rows);
+// Must be called during v-blank, when the page is being put on screen
+void hybrid_present(void);
+
+#endif // GUARD_HYBRID_H
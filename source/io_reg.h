@@ -773,4 +773,14 @@
 #define WAITCNT_AGB (0 << 15)
 #define WAITCNT_CGB (1 << 15)
 
+// Wait states set at startup: 3/1 cycles for ROM (the fastest setting all
+// cartridges support) with the prefetch buffer on. The power-on value is 0,
+// which is 4/2 cycles without prefetch.
+#define WAITCNT_FAST (WAITCNT_WS0_N_3 | WAITCNT_WS0_S_1 | WAITCNT_PREFETCH_ENABLE)
+
+// the register definitions above are disabled in favor of libgba's
+#ifndef REG_WAITCNT
+#define REG_WAITCNT (*(vu16 *)REG_ADDR_WAITCNT)
+#endif
+
 #endif // GUARD_GBA_IO_REG_H
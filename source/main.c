@@ -15,11 +15,19 @@
 
 #include "io_reg.h"
 #include "macro.h"
+#include "bench.h"
+#include "debug.h"
+#include "governor.h"
+#include "hybrid.h"
+#include "profile.h"
+#include "render.h"
+#include "replay.h"
+#include "sampler.h"
+#include "timer.h"
+#include "trig.h"
 
 #include "colormap.h"
 
-#include "terrain_bin.h"
-
 #include "r6502_portfont_bin.h"
 
 struct OamData
@@ -41,9 +49,6 @@ struct OamData
     /*0x06*/ u16 affineParam;
 };
 
-// represents a signed Q16.16 fixed point number
-typedef s32 fixed_t;
-
 static struct
 {
     u16 keysDown;
@@ -51,383 +56,56 @@ static struct
     u16 newKeys;
 } input = {0};
 
-struct
-{
-    /*0x00*/ fixed_t x;
-    /*0x04*/ fixed_t y;
-    /*0x08*/ s32 height;
-    /*0x0C*/ s32 horizon;
-    /*0x10*/ fixed_t sinYaw;
-    /*0x14*/ fixed_t cosYaw;
-    /*0x18*/ s16 yaw;
-} camera;
-
-// buffer to write to (this is the back buffer
-u16 *frameBuffer;
-static int fbNum = 0;
-
-// Converts a number to Q8.8 fixed-point format
-#define Q_8_8(n) ((s16)((n) * 256))
-
-// Values of sin(x*(π/128)) as Q8.8 fixed-point numbers from x = 0 to x = 319
-static const s16 gSineTable[] =
-{
-    Q_8_8(0),           // sin(0*(π/128))
-    Q_8_8(0.0234375),   // sin(1*(π/128))
-    Q_8_8(0.046875),    // sin(2*(π/128))
-    Q_8_8(0.0703125),   // sin(3*(π/128))
-    Q_8_8(0.09765625),  // sin(4*(π/128))
-    Q_8_8(0.12109375),  // sin(5*(π/128))
-    Q_8_8(0.14453125),  // sin(6*(π/128))
-    Q_8_8(0.16796875),  // sin(7*(π/128))
-    Q_8_8(0.19140625),  // sin(8*(π/128))
-    Q_8_8(0.21875),     // sin(9*(π/128))
-    Q_8_8(0.2421875),   // sin(10*(π/128))
-    Q_8_8(0.265625),    // sin(11*(π/128))
-    Q_8_8(0.2890625),   // sin(12*(π/128))
-    Q_8_8(0.3125),      // sin(13*(π/128))
-    Q_8_8(0.3359375),   // sin(14*(π/128))
-    Q_8_8(0.359375),    // sin(15*(π/128))
-    Q_8_8(0.37890625),  // sin(16*(π/128))
-    Q_8_8(0.40234375),  // sin(17*(π/128))
-    Q_8_8(0.42578125),  // sin(18*(π/128))
-    Q_8_8(0.44921875),  // sin(19*(π/128))
-    Q_8_8(0.46875),     // sin(20*(π/128))
-    Q_8_8(0.4921875),   // sin(21*(π/128))
-    Q_8_8(0.51171875),  // sin(22*(π/128))
-    Q_8_8(0.53125),     // sin(23*(π/128))
-    Q_8_8(0.5546875),   // sin(24*(π/128))
-    Q_8_8(0.57421875),  // sin(25*(π/128))
-    Q_8_8(0.59375),     // sin(26*(π/128))
-    Q_8_8(0.61328125),  // sin(27*(π/128))
-    Q_8_8(0.6328125),   // sin(28*(π/128))
-    Q_8_8(0.65234375),  // sin(29*(π/128))
-    Q_8_8(0.66796875),  // sin(30*(π/128))
-    Q_8_8(0.6875),      // sin(31*(π/128))
-    Q_8_8(0.70703125),  // sin(32*(π/128))
-    Q_8_8(0.72265625),  // sin(33*(π/128))
-    Q_8_8(0.73828125),  // sin(34*(π/128))
-    Q_8_8(0.75390625),  // sin(35*(π/128))
-    Q_8_8(0.76953125),  // sin(36*(π/128))
-    Q_8_8(0.78515625),  // sin(37*(π/128))
-    Q_8_8(0.80078125),  // sin(38*(π/128))
-    Q_8_8(0.81640625),  // sin(39*(π/128))
-    Q_8_8(0.828125),    // sin(40*(π/128))
-    Q_8_8(0.84375),     // sin(41*(π/128))
-    Q_8_8(0.85546875),  // sin(42*(π/128))
-    Q_8_8(0.8671875),   // sin(43*(π/128))
-    Q_8_8(0.87890625),  // sin(44*(π/128))
-    Q_8_8(0.890625),    // sin(45*(π/128))
-    Q_8_8(0.90234375),  // sin(46*(π/128))
-    Q_8_8(0.9140625),   // sin(47*(π/128))
-    Q_8_8(0.921875),    // sin(48*(π/128))
-    Q_8_8(0.9296875),   // sin(49*(π/128))
-    Q_8_8(0.94140625),  // sin(50*(π/128))
-    Q_8_8(0.94921875),  // sin(51*(π/128))
-    Q_8_8(0.953125),    // sin(52*(π/128))
-    Q_8_8(0.9609375),   // sin(53*(π/128))
-    Q_8_8(0.96875),     // sin(54*(π/128))
-    Q_8_8(0.97265625),  // sin(55*(π/128))
-    Q_8_8(0.98046875),  // sin(56*(π/128))
-    Q_8_8(0.984375),    // sin(57*(π/128))
-    Q_8_8(0.98828125),  // sin(58*(π/128))
-    Q_8_8(0.9921875),   // sin(59*(π/128))
-    Q_8_8(0.9921875),   // sin(60*(π/128))
-    Q_8_8(0.99609375),  // sin(61*(π/128))
-    Q_8_8(0.99609375),  // sin(62*(π/128))
-    Q_8_8(0.99609375),  // sin(63*(π/128))
-    Q_8_8(1),           // sin(64*(π/128))
-    Q_8_8(0.99609375),  // sin(65*(π/128))
-    Q_8_8(0.99609375),  // sin(66*(π/128))
-    Q_8_8(0.99609375),  // sin(67*(π/128))
-    Q_8_8(0.9921875),   // sin(68*(π/128))
-    Q_8_8(0.9921875),   // sin(69*(π/128))
-    Q_8_8(0.98828125),  // sin(70*(π/128))
-    Q_8_8(0.984375),    // sin(71*(π/128))
-    Q_8_8(0.98046875),  // sin(72*(π/128))
-    Q_8_8(0.97265625),  // sin(73*(π/128))
-    Q_8_8(0.96875),     // sin(74*(π/128))
-    Q_8_8(0.9609375),   // sin(75*(π/128))
-    Q_8_8(0.953125),    // sin(76*(π/128))
-    Q_8_8(0.94921875),  // sin(77*(π/128))
-    Q_8_8(0.94140625),  // sin(78*(π/128))
-    Q_8_8(0.9296875),   // sin(79*(π/128))
-    Q_8_8(0.921875),    // sin(80*(π/128))
-    Q_8_8(0.9140625),   // sin(81*(π/128))
-    Q_8_8(0.90234375),  // sin(82*(π/128))
-    Q_8_8(0.890625),    // sin(83*(π/128))
-    Q_8_8(0.87890625),  // sin(84*(π/128))
-    Q_8_8(0.8671875),   // sin(85*(π/128))
-    Q_8_8(0.85546875),  // sin(86*(π/128))
-    Q_8_8(0.84375),     // sin(87*(π/128))
-    Q_8_8(0.828125),    // sin(88*(π/128))
-    Q_8_8(0.81640625),  // sin(89*(π/128))
-    Q_8_8(0.80078125),  // sin(90*(π/128))
-    Q_8_8(0.78515625),  // sin(91*(π/128))
-    Q_8_8(0.76953125),  // sin(92*(π/128))
-    Q_8_8(0.75390625),  // sin(93*(π/128))
-    Q_8_8(0.73828125),  // sin(94*(π/128))
-    Q_8_8(0.72265625),  // sin(95*(π/128))
-    Q_8_8(0.70703125),  // sin(96*(π/128))
-    Q_8_8(0.6875),      // sin(97*(π/128))
-    Q_8_8(0.66796875),  // sin(98*(π/128))
-    Q_8_8(0.65234375),  // sin(99*(π/128))
-    Q_8_8(0.6328125),   // sin(100*(π/128))
-    Q_8_8(0.61328125),  // sin(101*(π/128))
-    Q_8_8(0.59375),     // sin(102*(π/128))
-    Q_8_8(0.57421875),  // sin(103*(π/128))
-    Q_8_8(0.5546875),   // sin(104*(π/128))
-    Q_8_8(0.53125),     // sin(105*(π/128))
-    Q_8_8(0.51171875),  // sin(106*(π/128))
-    Q_8_8(0.4921875),   // sin(107*(π/128))
-    Q_8_8(0.46875),     // sin(108*(π/128))
-    Q_8_8(0.44921875),  // sin(109*(π/128))
-    Q_8_8(0.42578125),  // sin(110*(π/128))
-    Q_8_8(0.40234375),  // sin(111*(π/128))
-    Q_8_8(0.37890625),  // sin(112*(π/128))
-    Q_8_8(0.359375),    // sin(113*(π/128))
-    Q_8_8(0.3359375),   // sin(114*(π/128))
-    Q_8_8(0.3125),      // sin(115*(π/128))
-    Q_8_8(0.2890625),   // sin(116*(π/128))
-    Q_8_8(0.265625),    // sin(117*(π/128))
-    Q_8_8(0.2421875),   // sin(118*(π/128))
-    Q_8_8(0.21875),     // sin(119*(π/128))
-    Q_8_8(0.19140625),  // sin(120*(π/128))
-    Q_8_8(0.16796875),  // sin(121*(π/128))
-    Q_8_8(0.14453125),  // sin(122*(π/128))
-    Q_8_8(0.12109375),  // sin(123*(π/128))
-    Q_8_8(0.09765625),  // sin(124*(π/128))
-    Q_8_8(0.0703125),   // sin(125*(π/128))
-    Q_8_8(0.046875),    // sin(126*(π/128))
-    Q_8_8(0.0234375),   // sin(127*(π/128))
-    Q_8_8(0),           // sin(128*(π/128))
-    Q_8_8(-0.0234375),  // sin(129*(π/128))
-    Q_8_8(-0.046875),   // sin(130*(π/128))
-    Q_8_8(-0.0703125),  // sin(131*(π/128))
-    Q_8_8(-0.09765625), // sin(132*(π/128))
-    Q_8_8(-0.12109375), // sin(133*(π/128))
-    Q_8_8(-0.14453125), // sin(134*(π/128))
-    Q_8_8(-0.16796875), // sin(135*(π/128))
-    Q_8_8(-0.19140625), // sin(136*(π/128))
-    Q_8_8(-0.21875),    // sin(137*(π/128))
-    Q_8_8(-0.2421875),  // sin(138*(π/128))
-    Q_8_8(-0.265625),   // sin(139*(π/128))
-    Q_8_8(-0.2890625),  // sin(140*(π/128))
-    Q_8_8(-0.3125),     // sin(141*(π/128))
-    Q_8_8(-0.3359375),  // sin(142*(π/128))
-    Q_8_8(-0.359375),   // sin(143*(π/128))
-    Q_8_8(-0.37890625), // sin(144*(π/128))
-    Q_8_8(-0.40234375), // sin(145*(π/128))
-    Q_8_8(-0.42578125), // sin(146*(π/128))
-    Q_8_8(-0.44921875), // sin(147*(π/128))
-    Q_8_8(-0.46875),    // sin(148*(π/128))
-    Q_8_8(-0.4921875),  // sin(149*(π/128))
-    Q_8_8(-0.51171875), // sin(150*(π/128))
-    Q_8_8(-0.53125),    // sin(151*(π/128))
-    Q_8_8(-0.5546875),  // sin(152*(π/128))
-    Q_8_8(-0.57421875), // sin(153*(π/128))
-    Q_8_8(-0.59375),    // sin(154*(π/128))
-    Q_8_8(-0.61328125), // sin(155*(π/128))
-    Q_8_8(-0.6328125),  // sin(156*(π/128))
-    Q_8_8(-0.65234375), // sin(157*(π/128))
-    Q_8_8(-0.66796875), // sin(158*(π/128))
-    Q_8_8(-0.6875),     // sin(159*(π/128))
-    Q_8_8(-0.70703125), // sin(160*(π/128))
-    Q_8_8(-0.72265625), // sin(161*(π/128))
-    Q_8_8(-0.73828125), // sin(162*(π/128))
-    Q_8_8(-0.75390625), // sin(163*(π/128))
-    Q_8_8(-0.76953125), // sin(164*(π/128))
-    Q_8_8(-0.78515625), // sin(165*(π/128))
-    Q_8_8(-0.80078125), // sin(166*(π/128))
-    Q_8_8(-0.81640625), // sin(167*(π/128))
-    Q_8_8(-0.828125),   // sin(168*(π/128))
-    Q_8_8(-0.84375),    // sin(169*(π/128))
-    Q_8_8(-0.85546875), // sin(170*(π/128))
-    Q_8_8(-0.8671875),  // sin(171*(π/128))
-    Q_8_8(-0.87890625), // sin(172*(π/128))
-    Q_8_8(-0.890625),   // sin(173*(π/128))
-    Q_8_8(-0.90234375), // sin(174*(π/128))
-    Q_8_8(-0.9140625),  // sin(175*(π/128))
-    Q_8_8(-0.921875),   // sin(176*(π/128))
-    Q_8_8(-0.9296875),  // sin(177*(π/128))
-    Q_8_8(-0.94140625), // sin(178*(π/128))
-    Q_8_8(-0.94921875), // sin(179*(π/128))
-    Q_8_8(-0.953125),   // sin(180*(π/128))
-    Q_8_8(-0.9609375),  // sin(181*(π/128))
-    Q_8_8(-0.96875),    // sin(182*(π/128))
-    Q_8_8(-0.97265625), // sin(183*(π/128))
-    Q_8_8(-0.98046875), // sin(184*(π/128))
-    Q_8_8(-0.984375),   // sin(185*(π/128))
-    Q_8_8(-0.98828125), // sin(186*(π/128))
-    Q_8_8(-0.9921875),  // sin(187*(π/128))
-    Q_8_8(-0.9921875),  // sin(188*(π/128))
-    Q_8_8(-0.99609375), // sin(189*(π/128))
-    Q_8_8(-0.99609375), // sin(190*(π/128))
-    Q_8_8(-0.99609375), // sin(191*(π/128))
-    Q_8_8(-1),          // sin(192*(π/128))
-    Q_8_8(-0.99609375), // sin(193*(π/128))
-    Q_8_8(-0.99609375), // sin(194*(π/128))
-    Q_8_8(-0.99609375), // sin(195*(π/128))
-    Q_8_8(-0.9921875),  // sin(196*(π/128))
-    Q_8_8(-0.9921875),  // sin(197*(π/128))
-    Q_8_8(-0.98828125), // sin(198*(π/128))
-    Q_8_8(-0.984375),   // sin(199*(π/128))
-    Q_8_8(-0.98046875), // sin(200*(π/128))
-    Q_8_8(-0.97265625), // sin(201*(π/128))
-    Q_8_8(-0.96875),    // sin(202*(π/128))
-    Q_8_8(-0.9609375),  // sin(203*(π/128))
-    Q_8_8(-0.953125),   // sin(204*(π/128))
-    Q_8_8(-0.94921875), // sin(205*(π/128))
-    Q_8_8(-0.94140625), // sin(206*(π/128))
-    Q_8_8(-0.9296875),  // sin(207*(π/128))
-    Q_8_8(-0.921875),   // sin(208*(π/128))
-    Q_8_8(-0.9140625),  // sin(209*(π/128))
-    Q_8_8(-0.90234375), // sin(210*(π/128))
-    Q_8_8(-0.890625),   // sin(211*(π/128))
-    Q_8_8(-0.87890625), // sin(212*(π/128))
-    Q_8_8(-0.8671875),  // sin(213*(π/128))
-    Q_8_8(-0.85546875), // sin(214*(π/128))
-    Q_8_8(-0.84375),    // sin(215*(π/128))
-    Q_8_8(-0.828125),   // sin(216*(π/128))
-    Q_8_8(-0.81640625), // sin(217*(π/128))
-    Q_8_8(-0.80078125), // sin(218*(π/128))
-    Q_8_8(-0.78515625), // sin(219*(π/128))
-    Q_8_8(-0.76953125), // sin(220*(π/128))
-    Q_8_8(-0.75390625), // sin(221*(π/128))
-    Q_8_8(-0.73828125), // sin(222*(π/128))
-    Q_8_8(-0.72265625), // sin(223*(π/128))
-    Q_8_8(-0.70703125), // sin(224*(π/128))
-    Q_8_8(-0.6875),     // sin(225*(π/128))
-    Q_8_8(-0.66796875), // sin(226*(π/128))
-    Q_8_8(-0.65234375), // sin(227*(π/128))
-    Q_8_8(-0.6328125),  // sin(228*(π/128))
-    Q_8_8(-0.61328125), // sin(229*(π/128))
-    Q_8_8(-0.59375),    // sin(230*(π/128))
-    Q_8_8(-0.57421875), // sin(231*(π/128))
-    Q_8_8(-0.5546875),  // sin(232*(π/128))
-    Q_8_8(-0.53125),    // sin(233*(π/128))
-    Q_8_8(-0.51171875), // sin(234*(π/128))
-    Q_8_8(-0.4921875),  // sin(235*(π/128))
-    Q_8_8(-0.46875),    // sin(236*(π/128))
-    Q_8_8(-0.44921875), // sin(237*(π/128))
-    Q_8_8(-0.42578125), // sin(238*(π/128))
-    Q_8_8(-0.40234375), // sin(239*(π/128))
-    Q_8_8(-0.37890625), // sin(240*(π/128))
-    Q_8_8(-0.359375),   // sin(241*(π/128))
-    Q_8_8(-0.3359375),  // sin(242*(π/128))
-    Q_8_8(-0.3125),     // sin(243*(π/128))
-    Q_8_8(-0.2890625),  // sin(244*(π/128))
-    Q_8_8(-0.265625),   // sin(245*(π/128))
-    Q_8_8(-0.2421875),  // sin(246*(π/128))
-    Q_8_8(-0.21875),    // sin(247*(π/128))
-    Q_8_8(-0.19140625), // sin(248*(π/128))
-    Q_8_8(-0.16796875), // sin(249*(π/128))
-    Q_8_8(-0.14453125), // sin(250*(π/128))
-    Q_8_8(-0.12109375), // sin(251*(π/128))
-    Q_8_8(-0.09765625), // sin(252*(π/128))
-    Q_8_8(-0.0703125),  // sin(253*(π/128))
-    Q_8_8(-0.046875),   // sin(254*(π/128))
-    Q_8_8(-0.0234375),  // sin(255*(π/128))
-    Q_8_8(0),           // sin(256*(π/128))
-    Q_8_8(0.0234375),   // sin(257*(π/128))
-    Q_8_8(0.046875),    // sin(258*(π/128))
-    Q_8_8(0.0703125),   // sin(259*(π/128))
-    Q_8_8(0.09765625),  // sin(260*(π/128))
-    Q_8_8(0.12109375),  // sin(261*(π/128))
-    Q_8_8(0.14453125),  // sin(262*(π/128))
-    Q_8_8(0.16796875),  // sin(263*(π/128))
-    Q_8_8(0.19140625),  // sin(264*(π/128))
-    Q_8_8(0.21875),     // sin(265*(π/128))
-    Q_8_8(0.2421875),   // sin(266*(π/128))
-    Q_8_8(0.265625),    // sin(267*(π/128))
-    Q_8_8(0.2890625),   // sin(268*(π/128))
-    Q_8_8(0.3125),      // sin(269*(π/128))
-    Q_8_8(0.3359375),   // sin(270*(π/128))
-    Q_8_8(0.359375),    // sin(271*(π/128))
-    Q_8_8(0.37890625),  // sin(272*(π/128))
-    Q_8_8(0.40234375),  // sin(273*(π/128))
-    Q_8_8(0.42578125),  // sin(274*(π/128))
-    Q_8_8(0.44921875),  // sin(275*(π/128))
-    Q_8_8(0.46875),     // sin(276*(π/128))
-    Q_8_8(0.4921875),   // sin(277*(π/128))
-    Q_8_8(0.51171875),  // sin(278*(π/128))
-    Q_8_8(0.53125),     // sin(279*(π/128))
-    Q_8_8(0.5546875),   // sin(280*(π/128))
-    Q_8_8(0.57421875),  // sin(281*(π/128))
-    Q_8_8(0.59375),     // sin(282*(π/128))
-    Q_8_8(0.61328125),  // sin(283*(π/128))
-    Q_8_8(0.6328125),   // sin(284*(π/128))
-    Q_8_8(0.65234375),  // sin(285*(π/128))
-    Q_8_8(0.66796875),  // sin(286*(π/128))
-    Q_8_8(0.6875),      // sin(287*(π/128))
-    Q_8_8(0.70703125),  // sin(288*(π/128))
-    Q_8_8(0.72265625),  // sin(289*(π/128))
-    Q_8_8(0.73828125),  // sin(290*(π/128))
-    Q_8_8(0.75390625),  // sin(291*(π/128))
-    Q_8_8(0.76953125),  // sin(292*(π/128))
-    Q_8_8(0.78515625),  // sin(293*(π/128))
-    Q_8_8(0.80078125),  // sin(294*(π/128))
-    Q_8_8(0.81640625),  // sin(295*(π/128))
-    Q_8_8(0.828125),    // sin(296*(π/128))
-    Q_8_8(0.84375),     // sin(297*(π/128))
-    Q_8_8(0.85546875),  // sin(298*(π/128))
-    Q_8_8(0.8671875),   // sin(299*(π/128))
-    Q_8_8(0.87890625),  // sin(300*(π/128))
-    Q_8_8(0.890625),    // sin(301*(π/128))
-    Q_8_8(0.90234375),  // sin(302*(π/128))
-    Q_8_8(0.9140625),   // sin(303*(π/128))
-    Q_8_8(0.921875),    // sin(304*(π/128))
-    Q_8_8(0.9296875),   // sin(305*(π/128))
-    Q_8_8(0.94140625),  // sin(306*(π/128))
-    Q_8_8(0.94921875),  // sin(307*(π/128))
-    Q_8_8(0.953125),    // sin(308*(π/128))
-    Q_8_8(0.9609375),   // sin(309*(π/128))
-    Q_8_8(0.96875),     // sin(310*(π/128))
-    Q_8_8(0.97265625),  // sin(311*(π/128))
-    Q_8_8(0.98046875),  // sin(312*(π/128))
-    Q_8_8(0.984375),    // sin(313*(π/128))
-    Q_8_8(0.98828125),  // sin(314*(π/128))
-    Q_8_8(0.9921875),   // sin(315*(π/128))
-    Q_8_8(0.9921875),   // sin(316*(π/128))
-    Q_8_8(0.99609375),  // sin(317*(π/128))
-    Q_8_8(0.99609375),  // sin(318*(π/128))
-    Q_8_8(0.99609375),  // sin(319*(π/128))
-};
-
-u32 inverseTable[512];
-
-fixed_t float_to_fixed(float n)
-{
-    return round(n * (1 << 16));
-}
+// SELECT was released without pressing L or R while it was held
+static int selectTapped = 0;
 
-/*
-// angle from 0 to 65535, where 65536 represents a whole rotation (360deg)
-fixed_t fixed_sin(int angle)
-{
-    angle &= 0xFFFF;  // wrap around
-    return float_to_fixed(sin(angle * (2*M_PI) / 65536.0));
-}
+struct Camera camera;
 
-fixed_t fixed_cos(int angle)
-{
-    return fixed_sin(angle + 65536 / 4);
-}
-*/
+// buffer to write to (this is the back buffer)
+u16 *frameBuffer;
+static int fbNum = 0;
 
-// angle from 0 to 65535, where 65536 represents a whole rotation (360deg)
-fixed_t fixed_sin(int angle)
+// internal resolution of the next frame (see gResolutions)
+#ifdef HYBRID
+static int resolution = HYBRID_RESOLUTION;
+#else
+static int resolution = RESOLUTION_FULL;
+#endif
+// and of the page on screen
+static int shownResolution = RESOLUTION_FULL;
+
+// the governor steps the resolution too, except in the builds that render at
+// only one
+#if defined(MODE5) || defined(HYBRID)
+#define GOVERNED_RESOLUTION NULL
+#else
+#define GOVERNED_RESOLUTION (&resolution)
+#endif
+
+// interlaced rendering, toggled with SELECT (see renderInterlaced)
+static int interlaceEnabled = 0;
+
+#ifndef HYBRID  // the line tables of hybrid.c hold the scales instead
+// BG2 scales from the screen to the page rendered at a resolution. MODE5
+// builds always render the one Mode 5 page size.
+static s32 page_column_scale(int res)
 {
-    s32 s;
-    angle &= 0xFFFF;  // wrap around
-    s = gSineTable[(angle >> 8) & 0xFF];
-    return s << 8;
+#ifdef MODE5
+    return MODE5_COLUMN_SCALE;
+#else
+    return RENDER_COLUMN_SCALE(gResolutions[res].columns);
+#endif
 }
 
-fixed_t fixed_cos(int angle)
+static s32 page_row_scale(int res)
 {
-    return fixed_sin(angle + (65536 / 4));
+#ifdef MODE5
+    return MODE5_ROW_SCALE;
+#else
+    return RENDER_ROW_SCALE(gResolutions[res].rows);
+#endif
 }
+#endif
 
 // HUD
 
@@ -540,10 +218,208 @@ void vblank_busy_wait(void)
         ;
 }
 
-void initialize(void)
+// Affine reprojection
+//
+// Toggled with B. While it is on, the look controls are applied at every
+// v-blank instead of once per rendered frame, and the page on screen is moved
+// with the BG2 affine offset to follow the current yaw and horizon until the
+// next rendered frame is presented. A horizon change moves the image by as
+// many rows, and a small yaw change moves it sideways by about 128 pixels per
+// radian (the renderers spread 2z across 256 pixels at distance z), both
+// scaled to the internal resolution of the page. Mode 4 pages are exactly the
+// size of the screen, so there is no guard band: the strips uncovered at the
+// edges show the backdrop, which is set to the sky color.
+//
+// Only turning and looking up or down is reprojected, and only as far as
+// REPROJECT_MAX_YAW and REPROJECT_MAX_HORIZON from the page on screen. Within
+// that, the main loop does not render at all while the look controls are
+// held, and renders once they are released or the camera moves.
+//
+// Builds that record or replay input need every look change to go through
+// read_input(), and sampler_irq owns the interrupt vector, so they leave it
+// out, and HYBRID builds move BG2 line by line instead (see hybrid.h).
+#if !defined(INPUT_RECORD) && !defined(INPUT_REPLAY) && !defined(PC_SAMPLER) && !defined(HYBRID)
+#define HAVE_REPROJECTION
+#endif
+
+// Applies the look controls held in keys to a yaw and horizon
+static void look(u16 keys, s16 *yaw, s32 *horizon)
 {
-    int i;
+    int vert = 0;
+    int horiz = 0;
+
+    if (keys & KEY_LEFT)
+        horiz = -1000;
+    if (keys & KEY_RIGHT)
+        horiz = +1000;
+    if (keys & KEY_UP)
+        vert = -10;
+    if (keys & KEY_DOWN)
+        vert = 10;
+
+    *yaw -= horiz;
+    *horizon -= vert;
+}
+
+#ifdef HAVE_REPROJECTION
+
+static int reprojectEnabled = 0;
+
+// the view, updated by the v-blank handler while reprojection is on
+static volatile s16 viewYaw;
+static volatile s32 viewHorizon;
+
+// the yaw and horizon the page on screen was rendered with
+static s16 shownYaw;
+static s32 shownHorizon;
+
+// 2000 yaw units move the page about 24 pixels, a tenth of the screen
+#define REPROJECT_MAX_YAW     2000
+#define REPROJECT_MAX_HORIZON 20
+
+// Returns nonzero if moving the page on screen still covers the view
+static int reprojection_covers_view(void)
+{
+    s16 yawDelta = viewYaw - shownYaw;
+    s32 horizonDelta = viewHorizon - shownHorizon;
+
+    return yawDelta >= -REPROJECT_MAX_YAW && yawDelta <= REPROJECT_MAX_YAW
+        && horizonDelta >= -REPROJECT_MAX_HORIZON && horizonDelta <= REPROJECT_MAX_HORIZON;
+}
+
+// must be called during v-blank
+static void reproject_shown_page(void)
+{
+    s16 yawDelta = viewYaw - shownYaw;
+
+    // 201 / 16384 ~= 128 * 2pi / 65536 pixels per yaw unit, in 24.8 fixed point
+    REG_BG2X = -((yawDelta * 201) >> 6) * page_column_scale(shownResolution) >> 8;
+    REG_BG2Y = -(viewHorizon - shownHorizon) * page_row_scale(shownResolution);
+}
+
+static void reproject_vblank(void)
+{
+    s16 yaw = viewYaw;
+    s32 horizon = viewHorizon;
+
+    look(~REG_KEYINPUT, &yaw, &horizon);
+    viewYaw = yaw;
+    viewHorizon = horizon;
+    reproject_shown_page();
+}
+
+static void reproject_toggle(void)
+{
+    reprojectEnabled = !reprojectEnabled;
+    if (reprojectEnabled)
+    {
+        viewYaw = camera.yaw;
+        viewHorizon = camera.horizon;
+        irqSet(IRQ_VBLANK, reproject_vblank);
+        irqEnable(IRQ_VBLANK);
+    }
+    else
+    {
+        irqDisable(IRQ_VBLANK);
+        irqSet(IRQ_VBLANK, NULL);
+        REG_BG2X = 0;
+        REG_BG2Y = 0;
+    }
+}
+
+#endif // HAVE_REPROJECTION
+
+// Must be called during v-blank, when the page rendered with the current
+// camera is being put on screen
+static void present_rendered_page(void)
+{
+#ifdef HAVE_REPROJECTION
+    // don't let the v-blank handler see a half updated page camera
+    REG_IME = 0;
+    shownYaw = camera.yaw;
+    shownHorizon = camera.horizon;
+#endif
+    // stretch the rendered area to the screen
+    shownResolution = resolution;
+#ifdef HYBRID
+    hybrid_present();
+#else
+    REG_BG2PA = page_column_scale(resolution);
+    REG_BG2PD = page_row_scale(resolution);
+#endif
+#ifdef HAVE_REPROJECTION
+    if (reprojectEnabled)
+        reproject_shown_page();
+    REG_IME = 1;
+#endif
+    swap_buffers();
+}
+
+// Halts the CPU until the keys differ from input.keysDown, waking up at each
+// v-blank to check, and returns during v-blank
+static void vblank_wait_for_input(void)
+{
+#if defined(INPUT_REPLAY) || defined(PC_SAMPLER)
+    // replayed input does not come from the keypad, and sampler_irq does
+    // not handle the v-blank interrupt
+    vblank_busy_wait();
+#else
+    irqEnable(IRQ_VBLANK);
+    do
+        VBlankIntrWait();
+    while ((u16)~REG_KEYINPUT == input.keysDown
+#ifdef HAVE_REPROJECTION
+        && (!reprojectEnabled || reprojection_covers_view())
+#endif
+        );
+#if defined(HYBRID)
+    // the line DMA is rearmed by the v-blank handler
+#elif defined(HAVE_REPROJECTION)
+    // the reprojection handler keeps running
+    if (!reprojectEnabled)
+        irqDisable(IRQ_VBLANK);
+#else
+    irqDisable(IRQ_VBLANK);
+#endif
+#endif
+}
 
+// the page being displayed (the other one is the back buffer)
+static u16 *front_buffer(void)
+{
+    return (fbNum == 0) ? (void *)(VRAM) : (void *)(VRAM + 0xA000);
+}
+
+// Returns nonzero if anything that affects the rendered image has changed
+// since the last call that returned nonzero
+static int scene_changed(void)
+{
+    static struct Camera lastCamera;
+    static int lastQuality;
+    static int lastResolution;
+    static int lastInterlaced;
+    static int valid = 0;
+
+    if (valid
+     && camera.x == lastCamera.x
+     && camera.y == lastCamera.y
+     && camera.height == lastCamera.height
+     && camera.horizon == lastCamera.horizon
+     && camera.yaw == lastCamera.yaw
+     && renderQuality == lastQuality
+     && resolution == lastResolution
+     && interlaceEnabled == lastInterlaced)
+        return 0;
+    lastCamera = camera;
+    lastQuality = renderQuality;
+    lastResolution = resolution;
+    lastInterlaced = interlaceEnabled;
+    valid = 1;
+    return 1;
+}
+
+void initialize(void)
+{
     // the vblank interrupt must be enabled for VBlankIntrWait() to work
     // since the default dispatcher handles the bios flags no vblank handler
     // is required
@@ -553,16 +429,30 @@ void initialize(void)
     //irqEnable(IRQ_VBLANK);
 
     // Set registers
+    REG_WAITCNT = WAITCNT_FAST;
+#ifdef MODE5
+    REG_DISPCNT = DISPCNT_MODE_5 | DISPCNT_BG2_ON | DISPCNT_OBJ_ON;
+    REG_BG2PA = MODE5_COLUMN_SCALE;
+    REG_BG2PD = MODE5_ROW_SCALE;
+    mode5SkyColor = colormapPal[BG_COLOR];
+#else
     REG_DISPCNT = DISPCNT_MODE_4 | DISPCNT_BG2_ON | DISPCNT_OBJ_ON;
+#endif
 
     // Load palette
     memcpy((void *)BG_PALETTE, colormapPal, 256 * sizeof(u16));
+    // The terrain never uses color 0, the backdrop. Make it the sky so that
+    // the edges uncovered by reprojection blend in.
+    BG_PALETTE[0] = colormapPal[BG_COLOR];
+
+    render_init();
+#ifdef HYBRID
+    hybrid_init();
+#endif
+#ifdef SKYLINE
+    renderSkylineZ = SKYLINE_Z;
+#endif
 
-
-    // Compute fixed point inverses
-    for (i = 1; i < 512; i++)
-        inverseTable[i] = (1 << 16) / (u32)i;
-    
     //VBlankIntrWait();
     vblank_busy_wait();
     hud_initialize();
@@ -571,149 +461,97 @@ void initialize(void)
 void read_input(void)
 {
     input.prevKeys = input.keysDown;
+#ifdef INPUT_REPLAY
+    input.keysDown = replay_next_keys();
+#else
     input.keysDown = ~REG_KEYINPUT;
+#endif
+#ifdef INPUT_RECORD
+    record_keys(input.keysDown);
+#endif
     input.newKeys = input.keysDown & (input.prevKeys ^ input.keysDown);
 }
 
 void update(void)
 {
-    int vert = 0;
-    int horiz = 0;
+    static int selectUsed = 0;  // L or R was pressed while SELECT was held
     int forward = 0;
 
-    if (input.keysDown & KEY_LEFT)
-        horiz = -1000;
-    if (input.keysDown & KEY_RIGHT)
-        horiz = +1000;
-    if (input.keysDown & KEY_UP)
-        vert = -10;
-    if (input.keysDown & KEY_DOWN)
-        vert = 10;
     if (input.keysDown & A_BUTTON)
         forward = 1;
 
-    camera.yaw -= horiz;
-    camera.sinYaw = fixed_sin(camera.yaw);
-    camera.cosYaw = fixed_cos(camera.yaw);
-    camera.x -= forward * camera.sinYaw * 4;
-    camera.y -= forward * camera.cosYaw * 4;
-    camera.horizon -= vert;
-    camera.height += forward * (camera.horizon - 100) / 16;
-}
-
-static inline void draw_vertical_bar(int x, int top, int bottom, u8 color)
-{
-    int y;
-    //if (top < 0)
-    //    top = 0;
-    //if (bottom < top)
-   //     return;
-    //if (bottom > 160)
-    //    bottom = 160;
-    //assert(bottom <= 160);
-
-    u16 *dest = (u16 *)frameBuffer + top * SCREEN_WIDTH/2 + x;
-    for (y = top; y < bottom; y++)
+#ifdef HAVE_REPROJECTION
+    if (input.newKeys & KEY_B)
+        reproject_toggle();
+    // The v-blank handler applies the look controls while reprojecting. The
+    // camera only picks them up, which renders a frame, when the page on
+    // screen no longer covers the view, the controls are released or the
+    // camera moves.
+    if (reprojectEnabled)
     {
-        *dest = color | (color << 8);
-        dest += SCREEN_WIDTH/2;
-    }
-}
-
-#define BG_COLOR 251
-
-__attribute__((section(".iwram"), target("arm"), long_call))
-void render_c(void)
-{
-    int i;
-    /*__attribute__((aligned(4))*/ u8 ybuffer[SCREEN_WIDTH/2] ALIGN(4);
-
-    /*
-    DmaFill32(3, BG_COLOR|(BG_COLOR<<8)|(BG_COLOR<<16)|(BG_COLOR<<24), frameBuffer, 160 * 240);
-
-    for (i = 0; i < SCREEN_WIDTH/2; i++)
-        ybuffer[i] = 160;
-    */
-    CpuFastFill(BG_COLOR|(BG_COLOR<<8)|(BG_COLOR<<16)|(BG_COLOR<<24), frameBuffer, 160 * 240);
-    CpuFill32(160|(160<<8)|(160<<16)|(160<<24), ybuffer, sizeof(ybuffer));
-
-    fixed_t s = camera.sinYaw;
-    fixed_t c = camera.cosYaw;
-    const u32 drawdistance = 512;
-    u32 z;
-    for (z = 1; z < drawdistance;)
-    {
-        fixed_t lx = (-c * z - s * z);
-        fixed_t ly = (s * z - c * z);
-        fixed_t rx = (c * z - s * z);
-        fixed_t ry = (-s * z - c * z);
-        /*
-        fixed_t dx = (rx - lx) / 240;
-        fixed_t dy = (ry - ly) / 240;
-        */
-        // this is less accurate, but faster
-        fixed_t dx = (rx - lx) >> 8;
-        fixed_t dy = (ry - ly) >> 8;
-
-        dx *= 2;
-        dy *= 2;
-
-        lx += (camera.x);
-        ly += (camera.y);
-
-        //fixed_t invz = 65536 / z;
-        fixed_t invz = inverseTable[z];
-
-        for (i = 0; i < SCREEN_WIDTH/2; i++, ly += dy, lx += dx)
+        if (forward || !(input.keysDown & (KEY_LEFT | KEY_RIGHT | KEY_UP | KEY_DOWN))
+         || !reprojection_covers_view())
         {
-            u32 index = ((ly >> 16) & 1023) * 1024 + ((lx >> 16) & 1023);
-            /*
-            u32 index2 = ((ly >> 15) & (1023<<1)) * 1024 + ((lx >> 15) & (1023<<1));
-            assert(index2 == index * 2);
-            */
-            //if ((u32)ly >= 2*1024 << 16 || (u32)lx >= 2*1024 << 16) continue; // bounds
-            s32 height = ((128 * (camera.height - terrain_bin[index * 2 + 1]) * invz) >> 16) + camera.horizon;
-            if (height < 0)
-                height = 0;
-            if (height < ybuffer[i])
-            {
-                u8 color = terrain_bin[index * 2];
-                draw_vertical_bar(i, height, ybuffer[i], color);
-                ybuffer[i] = height;
-            }
+            camera.yaw = viewYaw;
+            camera.horizon = viewHorizon;
         }
-        if (z >= 256)
-            z += 8;
-        if (z >= 128)
-            z += 4;
-        else
-            z += 2;
     }
-}
-
-extern __attribute__((section(".iwram"), target("arm"), long_call)) void render_asm(void);
-
-static void start_timer(void)
-{
-    #define TM_ENABLE (1 << 7)
-    #define TM_CASCADE (1 << 2)
-    
-    // Disable timers and make them count from zero
-    REG_TM3CNT = 0;
-    REG_TM2CNT = 0;
-
-    // start timers
-    REG_TM3CNT_H = TM_ENABLE | TM_CASCADE;
-    REG_TM2CNT_H = TM_ENABLE;
-}
+    else
+#endif
+    {
+        look(input.keysDown, &camera.yaw, &camera.horizon);
+    }
 
-static u32 stop_timer(void)
-{
-    u32 time = (REG_TM3CNT_L << 16) | REG_TM2CNT_L;
+    // With SELECT held, L and R step through the internal resolutions (see
+    // gResolutions), R towards lower ones and L up to paired mode, and take
+    // over from the governor like the quality presets below
+    if (input.newKeys & KEY_SELECT)
+        selectUsed = 0;
+    if (input.keysDown & KEY_SELECT)
+    {
+#if !defined(MODE5) && !defined(HYBRID)
+        if (input.newKeys & (KEY_L | KEY_R))
+            governorEnabled = 0;
+        if ((input.newKeys & KEY_R) && resolution < RESOLUTION_COUNT - 1)
+            resolution++;
+        if ((input.newKeys & KEY_L) && resolution > 0)
+            resolution--;
+#endif
+        if (input.newKeys & (KEY_L | KEY_R))
+            selectUsed = 1;
+    }
+    // Otherwise they step through the quality presets, R towards faster
+    // ones, and take over from the governor until START hands control back
+    // to it
+    else
+    {
+        if (input.newKeys & (KEY_L | KEY_R))
+            governorEnabled = 0;
+        if ((input.newKeys & KEY_R) && renderQuality < QUALITY_PRESET_COUNT - 1)
+            render_set_quality(renderQuality + 1);
+        if ((input.newKeys & KEY_L) && renderQuality > 0)
+            render_set_quality(renderQuality - 1);
+    }
+#ifndef INPUT_REPLAY
+    // replays log frame CRCs, which must not depend on the render time
+    if (input.newKeys & KEY_START)
+        governor_init(GOVERNOR_TARGET_30FPS, GOVERNED_RESOLUTION);
+#endif
+    // SELECT on its own is a tap when it is released
+    selectTapped = (input.prevKeys & ~input.keysDown & KEY_SELECT) && !selectUsed;
+#if !defined(RENDER_PROFILE) && !defined(PC_SAMPLER) && !defined(MODE5) && !defined(HYBRID)
+    // A tap switches interlaced rendering on and off (the profiling builds
+    // use it for their dumps, so they can only compare the two in bench, and
+    // the Mode 5 and hybrid renderers are never interlaced)
+    if (selectTapped)
+        interlaceEnabled = !interlaceEnabled;
+#endif
 
-    REG_TM3CNT = 0;
-    REG_TM2CNT = 0;
-    return time;
+    camera.sinYaw = fixed_sin(camera.yaw);
+    camera.cosYaw = fixed_cos(camera.yaw);
+    camera.x -= forward * camera.sinYaw * 4;
+    camera.y -= forward * camera.cosYaw * 4;
+    camera.height += forward * (camera.horizon - 100) / 16;
 }
 
 //---------------------------------------------------------------------------------
@@ -733,25 +571,138 @@ int main(void)
     camera.height = 70;
     camera.yaw = 0;
     camera.horizon = 100;
+#ifdef SKYLINE
+    render_build_skyline();
+#endif
+
+#ifdef BENCHMARK
+    bench_run();
+#endif
+#if defined(RENDER_PROFILE) || defined(PC_SAMPLER) || defined(INPUT_REPLAY)
+    debug_init();
+#endif
+#ifdef INPUT_RECORD
+    record_init();
+#endif
+#ifdef INPUT_REPLAY
+    replay_init();
+#endif
+#ifdef PC_SAMPLER
+    sampler_start();
+#endif
+#ifndef INPUT_REPLAY
+    // replays log frame CRCs, which must not depend on the render time
+    governor_init(GOVERNOR_TARGET_30FPS, GOVERNED_RESOLUTION);
+#endif
 
     while (1) {
+        // In interlaced mode each frame renders one field and copies the
+        // other from the page on screen, so after the camera stops it takes
+        // one more frame to replace the field rendered before it stopped
+        static int otherFieldStale = 0;
+#ifdef SKYLINE
+        // and the skyline takes a few to catch up with it (see
+        // render_update_skyline)
+        static int skylineStale = 0;
+#endif
+        int changed;
+        int rendered;
+
         read_input();
         update();
-        start_timer();
-        //render_c();  // 609191 cycles
-        render_asm();
-        renderTime = stop_timer();
-        frames++;
+#ifdef RENDER_PROFILE
+        profile_begin_frame();
+#endif
+        changed = scene_changed();
+        rendered = changed || otherFieldStale;
+#ifdef SKYLINE
+        rendered = rendered || skylineStale;
+#endif
+        if (rendered)
+        {
+            const struct Resolution *res = &gResolutions[resolution];
+
+            // the other field can only be copied from a page of the same
+            // resolution, and paired mode draws every column anyway
+            renderInterlaced = interlaceEnabled && shownResolution == resolution
+                && res->columns != SCREEN_WIDTH;
+            start_timer();
+#ifdef SKYLINE
+            skylineStale = render_update_skyline(SKYLINE_UPDATE_DIRECTIONS, SKYLINE_BACKGROUND_DIRECTIONS);
+#endif
+#ifdef MODE5
+            render_mode5_c();
+#else
+            //render_c(res->columns, res->rows);  // 609191 cycles
+            render_asm(res->columns, res->rows);
+#endif
+#ifdef HYBRID
+            hybrid_update_page(res->columns, res->rows);
+#endif
+            if (renderInterlaced)
+            {
+                copy_field_asm(frameBuffer, front_buffer(), renderField ^ 1);
+                renderField ^= 1;
+            }
+            renderTime = stop_timer();
+            otherFieldStale = renderInterlaced && changed;
+            frames++;
+            governor_update(renderTime);
+#ifdef INPUT_REPLAY
+            replay_log_frame(frameBuffer, renderTime);
+#endif
+        }
+        else
+        {
+            // the camera has not moved, so keep presenting the last frame
+            renderTime = 0;
+#ifdef INPUT_REPLAY
+            replay_log_frame(front_buffer(), renderTime);
+#endif
+        }
         sprintf(hudText,
+#ifdef RENDER_PROFILE
+            // The profile needs up to 56 characters of hudText (see
+            // profile_format_hud), so the position is left out and the
+            // settings share a line, which leaves these at most 61
+            "render time: %lu cycles\n"
+            "%s%s %s%s\n",
+#else
             "position: %i, %i, %i\n"
-            "render time: %lu cycles\n",
+            "render time: %lu cycles\n"
+            "quality: %s%s\n"
+            "%s%s\n",
             (int)(camera.x >> 16), (int)(camera.y >> 16), (int)camera.height,
-            renderTime);
+#endif
+            renderTime, gQualityPresets[renderQuality].name, governorEnabled ? " (auto)" : "",
+#ifdef MODE5
+            "160x128", " mode 5");
+#elif defined(HYBRID)
+            gResolutions[resolution].name, " hybrid");
+#elif defined(SKYLINE)
+            gResolutions[resolution].name, " skyline");
+#else
+            gResolutions[resolution].name,
+            (interlaceEnabled && gResolutions[resolution].columns != SCREEN_WIDTH) ? " interlaced" : "");
+#endif
+#ifdef RENDER_PROFILE
+        profile_format_hud(hudText + strlen(hudText), sizeof(hudText) - strlen(hudText));
+        // a SELECT tap dumps the full profile of this frame
+        if (selectTapped)
+            profile_dump();
+#endif
+#ifdef PC_SAMPLER
+        // a SELECT tap dumps the samples taken since the last dump
+        if (selectTapped)
+            sampler_dump();
+#endif
         //VBlankIntrWait();
-        vblank_busy_wait();
+        if (rendered)
+            vblank_busy_wait();
+        else
+            vblank_wait_for_input();
         hud_update();
-        swap_buffers();
+        if (rendered)
+            present_rendered_page();
     }
 }
-
-
@@ -0,0 +1,41 @@
+#include <gba_base.h>
+
+#include "poses.h"
+#include "render.h"
+#include "trig.h"
+
+const struct Pose gPoses[] =
+{
+    // name              x     y  height horizon  yaw
+    {"start",          512,  800,    70,  100,      0},
+    {"low-valley",     300,  600,    40,  100,  16384},
+    {"high-altitude",  512,  512,   250,  -40,  32768},
+    {"facing-cliff",   700,  200,    90,  100, -16384},
+    {"open-horizon",   100,  900,   180,   80,   8192},
+    {"look-down",      512,  800,   120,   20,  40960},
+    {"look-up",        300,  620,    45,  140,  57344},
+    {"map-edge",      1020,    4,   100,  100,  24576},
+    {"ridge-wall",     385,  224,    32,  133,  24576},
+    // each yaw octant from the starting position
+    {"yaw-0",          512,  800,    70,  100,      0},
+    {"yaw-1",          512,  800,    70,  100,   8192},
+    {"yaw-2",          512,  800,    70,  100,  16384},
+    {"yaw-3",          512,  800,    70,  100,  24576},
+    {"yaw-4",          512,  800,    70,  100,  32768},
+    {"yaw-5",          512,  800,    70,  100,  40960},
+    {"yaw-6",          512,  800,    70,  100,  49152},
+    {"yaw-7",          512,  800,    70,  100,  57344},
+};
+
+const unsigned int gPoseCount = sizeof(gPoses) / sizeof(gPoses[0]);
+
+void set_camera_pose(const struct Pose *pose)
+{
+    camera.x = pose->x << 16;
+    camera.y = pose->y << 16;
+    camera.height = pose->height;
+    camera.horizon = pose->horizon;
+    camera.yaw = pose->yaw;
+    camera.sinYaw = fixed_sin(camera.yaw);
+    camera.cosYaw = fixed_cos(camera.yaw);
+}
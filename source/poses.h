@@ -0,0 +1,22 @@
+#ifndef GUARD_POSES_H
+#define GUARD_POSES_H
+
+#include <gba_base.h>
+
+// A fixed camera pose used by the benchmark ROM and the host golden tests
+struct Pose
+{
+    const char *name;
+    s32 x;        // map coordinates (integer part of camera.x)
+    s32 y;        // map coordinates (integer part of camera.y)
+    s32 height;
+    s32 horizon;
+    s32 yaw;      // 0 to 65535
+};
+
+extern const struct Pose gPoses[];
+extern const unsigned int gPoseCount;
+
+void set_camera_pose(const struct Pose *pose);
+
+#endif // GUARD_POSES_H
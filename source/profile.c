@@ -0,0 +1,76 @@
+#include <gba_base.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "debug.h"
+#include "profile.h"
+
+#ifdef RENDER_PROFILE
+
+IWRAM_DATA struct RenderProfile renderProfile = {0};
+
+static const char *const sPhaseNames[PHASE_COUNT] =
+{
+    [PHASE_OTHER]       = "other",
+    [PHASE_SKY]         = "sky",
+    [PHASE_YBUFFER]     = "ybuffer",
+    [PHASE_SLICE_SETUP] = "slice_setup",
+    [PHASE_COLUMNS]     = "columns",
+    [PHASE_BARS]        = "bars",
+};
+
+// Must be called right before start_timer() so that the first mark measures
+// from zero
+void profile_begin_frame(void)
+{
+    memset(renderProfile.cycles, 0, sizeof(renderProfile.cycles));
+    memset(renderProfile.counts, 0, sizeof(renderProfile.counts));
+    memset(renderProfile.enters, 0, sizeof(renderProfile.enters));
+    renderProfile.phase = PHASE_OTHER;
+    renderProfile.lastTime = 0;
+}
+
+// Phase totals in thousands of cycles and the per-frame counters. For frames
+// under 10M cycles this is at most 56 characters: 32 on the first line, and
+// 24 on the second, as a frame samples at most 240 * MAX_Z_SLICES texels and
+// writes at most 240 * 160 pixels.
+void profile_format_hud(char *buffer, unsigned int size)
+{
+    const u32 *cycles = renderProfile.cycles;
+
+    snprintf(buffer, size,
+        "K%lu Y%lu S%lu L%lu B%lu k\n"
+        "tx%lu br%lu px%lu\n",
+        cycles[PHASE_SKY] / 1000, cycles[PHASE_YBUFFER] / 1000,
+        cycles[PHASE_SLICE_SETUP] / 1000, cycles[PHASE_COLUMNS] / 1000,
+        cycles[PHASE_BARS] / 1000,
+        renderProfile.counts[PHASE_COLUMNS],
+        renderProfile.enters[PHASE_BARS],
+        renderProfile.counts[PHASE_BARS]);
+}
+
+// Writes the last frame's profile as CSV through the debug log
+void profile_dump(void)
+{
+    unsigned int i;
+    unsigned int pos;
+
+    debug_printf("phase,cycles,count,enters");
+    for (i = 0; i < PHASE_COUNT; i++)
+        debug_printf("%s,%lu,%lu,%lu", sPhaseNames[i],
+            renderProfile.cycles[i], renderProfile.counts[i], renderProfile.enters[i]);
+    debug_printf("texels,%lu", renderProfile.counts[PHASE_COLUMNS]);
+    debug_printf("bars,%lu", renderProfile.enters[PHASE_BARS]);
+    debug_printf("pixels,%lu", renderProfile.counts[PHASE_BARS]);
+
+    // oldest ring entry first
+    debug_printf("ring,phase,time");
+    pos = renderProfile.ringPos;
+    for (i = 0; i < RENDER_PROFILE_RING_SIZE; i++)
+    {
+        u32 entry = renderProfile.ring[(pos + i) & (RENDER_PROFILE_RING_SIZE - 1)];
+        debug_printf("ring,%s,%lu", sPhaseNames[(entry >> 16) % PHASE_COUNT], entry & 0xFFFF);
+    }
+}
+
+#endif // RENDER_PROFILE
@@ -0,0 +1,50 @@
+#ifndef GUARD_PROFILE_H
+#define GUARD_PROFILE_H
+
+// Per-phase instrumentation of render_asm, enabled by building with
+// -DRENDER_PROFILE (make profile). render_asm marks each phase boundary by
+// reading the low half of the TM2/TM3 stopwatch, so no interrupts are
+// needed. Every interval between two marks must be shorter than 65536
+// cycles. Each mark costs a few dozen cycles, which are split between the
+// phases on either side of it, so compare profiles with each other rather
+// than with the uninstrumented render time.
+
+#ifdef RENDER_PROFILE
+
+#include <gba_base.h>
+
+// These must match the PHASE_* values in renderer.s
+enum RenderPhase
+{
+    PHASE_OTHER,        // prologue, epilogue and anything unmarked
+    PHASE_SKY,          // sky fill above the terrain, skyline projection, or span list rasterization
+    PHASE_YBUFFER,      // CpuSet of the y buffer
+    PHASE_SLICE_SETUP,  // per z slice setup before the column loop
+    PHASE_COLUMNS,      // column sampling (counts texels sampled)
+    PHASE_BARS,         // bar writer (counts pixels written)
+    PHASE_COUNT,
+};
+
+#define RENDER_PROFILE_RING_SIZE 256  // must be a power of two
+
+// The layout of this struct must match the o_profile_* offsets in renderer.s
+struct RenderProfile
+{
+    /*0x00*/ u32 cycles[PHASE_COUNT];  // cycles spent in each phase this frame
+    /*0x18*/ u32 counts[PHASE_COUNT];  // work items counted by each phase
+    /*0x30*/ u32 enters[PHASE_COUNT];  // number of times each phase was entered
+    /*0x48*/ u32 phase;                // current phase
+    /*0x4C*/ u32 lastTime;             // low 16 bits of the stopwatch at the last mark
+    /*0x50*/ u32 ringPos;              // next entry to write in ring
+    /*0x54*/ u32 ring[RENDER_PROFILE_RING_SIZE];  // (phase << 16) | stopwatch low bits
+};
+
+extern struct RenderProfile renderProfile;
+
+void profile_begin_frame(void);
+void profile_format_hud(char *buffer, unsigned int size);
+void profile_dump(void);
+
+#endif // RENDER_PROFILE
+
+#endif // GUARD_PROFILE_H
@@ -0,0 +1,975 @@
+#include <gba_base.h>
+#include <gba_systemcalls.h>
+#include <gba_video.h>
+
+#include "macro.h"
+#include "render.h"
+
+#include "colormap555_bin.h"
+#include "heightmax_bin.h"
+#include "terrain_bin.h"
+#include "terrainmip_bin.h"
+
+u8 terrainPeakHeight;
+struct ZSchedule zSchedule;
+int renderQuality;
+int renderInterlaced;
+int renderField;
+int renderSpanList;
+int renderColumnStrips;
+u32 renderPlaneZ;
+int renderPlaneRow;
+u16 mode5SkyColor;
+
+#ifdef HAVE_SKYLINE
+u32 renderSkylineZ;
+EWRAM_BSS struct SkylineDirection skyline[SKYLINE_DIRECTIONS];
+// the next direction of the view render_update_skyline rebuilds, counted
+// from its right edge, and the next one around the circle
+static int sSkylineCursor;
+static int sSkylineBackgroundCursor;
+// the camera and quality the view was last rebuilt for, and the directions
+// of the view left to rebuild since they changed
+static struct Camera sSkylineCamera;
+static int sSkylineQuality;
+static int sSkylineViewLeft;
+
+// The ray through the left edge of pixel column i is the view direction plus
+// t = (i - 128) / 128 times the right vector (see render_c), which turns it by
+// -atan(t) (in yaw units, here biased by half a direction) and lengthens it
+// by sqrt(1 + t * t)
+#define SKYLINE_RAY(yaw, secant) (((yaw) & 0xFFFF) | ((secant) << 16))
+
+const u32 skylineRays[SCREEN_WIDTH] =
+{
+    SKYLINE_RAY(8256, 362),   // column 0
+    SKYLINE_RAY(8215, 361),   // column 1
+    SKYLINE_RAY(8174, 359),   // column 2
+    SKYLINE_RAY(8132, 358),   // column 3
+    SKYLINE_RAY(8090, 356),   // column 4
+    SKYLINE_RAY(8048, 355),   // column 5
+    SKYLINE_RAY(8006, 354),   // column 6
+    SKYLINE_RAY(7963, 352),   // column 7
+    SKYLINE_RAY(7920, 351),   // column 8
+    SKYLINE_RAY(7876, 350),   // column 9
+    SKYLINE_RAY(7832, 348),   // column 10
+    SKYLINE_RAY(7788, 347),   // column 11
+    SKYLINE_RAY(7743, 345),   // column 12
+    SKYLINE_RAY(7699, 344),   // column 13
+    SKYLINE_RAY(7653, 343),   // column 14
+    SKYLINE_RAY(7608, 341),   // column 15
+    SKYLINE_RAY(7562, 340),   // column 16
+    SKYLINE_RAY(7515, 339),   // column 17
+    SKYLINE_RAY(7469, 338),   // column 18
+    SKYLINE_RAY(7422, 336),   // column 19
+    SKYLINE_RAY(7374, 335),   // column 20
+    SKYLINE_RAY(7326, 334),   // column 21
+    SKYLINE_RAY(7278, 332),   // column 22
+    SKYLINE_RAY(7230, 331),   // column 23
+    SKYLINE_RAY(7181, 330),   // column 24
+    SKYLINE_RAY(7132, 329),   // column 25
+    SKYLINE_RAY(7082, 327),   // column 26
+    SKYLINE_RAY(7032, 326),   // column 27
+    SKYLINE_RAY(6981, 325),   // column 28
+    SKYLINE_RAY(6931, 324),   // column 29
+    SKYLINE_RAY(6879, 322),   // column 30
+    SKYLINE_RAY(6828, 321),   // column 31
+    SKYLINE_RAY(6776, 320),   // column 32
+    SKYLINE_RAY(6724, 319),   // column 33
+    SKYLINE_RAY(6671, 318),   // column 34
+    SKYLINE_RAY(6618, 316),   // column 35
+    SKYLINE_RAY(6564, 315),   // column 36
+    SKYLINE_RAY(6510, 314),   // column 37
+    SKYLINE_RAY(6456, 313),   // column 38
+    SKYLINE_RAY(6401, 312),   // column 39
+    SKYLINE_RAY(6346, 311),   // column 40
+    SKYLINE_RAY(6291, 310),   // column 41
+    SKYLINE_RAY(6235, 308),   // column 42
+    SKYLINE_RAY(6178, 307),   // column 43
+    SKYLINE_RAY(6122, 306),   // column 44
+    SKYLINE_RAY(6064, 305),   // column 45
+    SKYLINE_RAY(6007, 304),   // column 46
+    SKYLINE_RAY(5949, 303),   // column 47
+    SKYLINE_RAY(5890, 302),   // column 48
+    SKYLINE_RAY(5832, 301),   // column 49
+    SKYLINE_RAY(5772, 300),   // column 50
+    SKYLINE_RAY(5713, 299),   // column 51
+    SKYLINE_RAY(5653, 298),   // column 52
+    SKYLINE_RAY(5592, 297),   // column 53
+    SKYLINE_RAY(5531, 296),   // column 54
+    SKYLINE_RAY(5470, 295),   // column 55
+    SKYLINE_RAY(5408, 294),   // column 56
+    SKYLINE_RAY(5346, 293),   // column 57
+    SKYLINE_RAY(5284, 292),   // column 58
+    SKYLINE_RAY(5221, 291),   // column 59
+    SKYLINE_RAY(5158, 290),   // column 60
+    SKYLINE_RAY(5094, 289),   // column 61
+    SKYLINE_RAY(5030, 288),   // column 62
+    SKYLINE_RAY(4965, 287),   // column 63
+    SKYLINE_RAY(4900, 286),   // column 64
+    SKYLINE_RAY(4835, 285),   // column 65
+    SKYLINE_RAY(4769, 284),   // column 66
+    SKYLINE_RAY(4703, 284),   // column 67
+    SKYLINE_RAY(4636, 283),   // column 68
+    SKYLINE_RAY(4569, 282),   // column 69
+    SKYLINE_RAY(4502, 281),   // column 70
+    SKYLINE_RAY(4434, 280),   // column 71
+    SKYLINE_RAY(4366, 279),   // column 72
+    SKYLINE_RAY(4297, 279),   // column 73
+    SKYLINE_RAY(4228, 278),   // column 74
+    SKYLINE_RAY(4159, 277),   // column 75
+    SKYLINE_RAY(4089, 276),   // column 76
+    SKYLINE_RAY(4019, 276),   // column 77
+    SKYLINE_RAY(3948, 275),   // column 78
+    SKYLINE_RAY(3877, 274),   // column 79
+    SKYLINE_RAY(3806, 273),   // column 80
+    SKYLINE_RAY(3734, 273),   // column 81
+    SKYLINE_RAY(3663, 272),   // column 82
+    SKYLINE_RAY(3590, 271),   // column 83
+    SKYLINE_RAY(3517, 271),   // column 84
+    SKYLINE_RAY(3444, 270),   // column 85
+    SKYLINE_RAY(3371, 269),   // column 86
+    SKYLINE_RAY(3297, 269),   // column 87
+    SKYLINE_RAY(3223, 268),   // column 88
+    SKYLINE_RAY(3149, 268),   // column 89
+    SKYLINE_RAY(3074, 267),   // column 90
+    SKYLINE_RAY(2999, 266),   // column 91
+    SKYLINE_RAY(2924, 266),   // column 92
+    SKYLINE_RAY(2848, 265),   // column 93
+    SKYLINE_RAY(2772, 265),   // column 94
+    SKYLINE_RAY(2696, 264),   // column 95
+    SKYLINE_RAY(2619, 264),   // column 96
+    SKYLINE_RAY(2542, 263),   // column 97
+    SKYLINE_RAY(2465, 263),   // column 98
+    SKYLINE_RAY(2388, 262),   // column 99
+    SKYLINE_RAY(2310, 262),   // column 100
+    SKYLINE_RAY(2232, 262),   // column 101
+    SKYLINE_RAY(2154, 261),   // column 102
+    SKYLINE_RAY(2076, 261),   // column 103
+    SKYLINE_RAY(1997, 260),   // column 104
+    SKYLINE_RAY(1918, 260),   // column 105
+    SKYLINE_RAY(1839, 260),   // column 106
+    SKYLINE_RAY(1760, 259),   // column 107
+    SKYLINE_RAY(1681, 259),   // column 108
+    SKYLINE_RAY(1601, 259),   // column 109
+    SKYLINE_RAY(1521, 259),   // column 110
+    SKYLINE_RAY(1441, 258),   // column 111
+    SKYLINE_RAY(1361, 258),   // column 112
+    SKYLINE_RAY(1281, 258),   // column 113
+    SKYLINE_RAY(1200, 258),   // column 114
+    SKYLINE_RAY(1120, 257),   // column 115
+    SKYLINE_RAY(1039, 257),   // column 116
+    SKYLINE_RAY(958, 257),    // column 117
+    SKYLINE_RAY(877, 257),    // column 118
+    SKYLINE_RAY(796, 257),    // column 119
+    SKYLINE_RAY(715, 256),    // column 120
+    SKYLINE_RAY(634, 256),    // column 121
+    SKYLINE_RAY(553, 256),    // column 122
+    SKYLINE_RAY(471, 256),    // column 123
+    SKYLINE_RAY(390, 256),    // column 124
+    SKYLINE_RAY(308, 256),    // column 125
+    SKYLINE_RAY(227, 256),    // column 126
+    SKYLINE_RAY(145, 256),    // column 127
+    SKYLINE_RAY(64, 256),     // column 128
+    SKYLINE_RAY(-17, 256),    // column 129
+    SKYLINE_RAY(-99, 256),    // column 130
+    SKYLINE_RAY(-180, 256),   // column 131
+    SKYLINE_RAY(-262, 256),   // column 132
+    SKYLINE_RAY(-343, 256),   // column 133
+    SKYLINE_RAY(-425, 256),   // column 134
+    SKYLINE_RAY(-506, 256),   // column 135
+    SKYLINE_RAY(-587, 256),   // column 136
+    SKYLINE_RAY(-668, 257),   // column 137
+    SKYLINE_RAY(-749, 257),   // column 138
+    SKYLINE_RAY(-830, 257),   // column 139
+    SKYLINE_RAY(-911, 257),   // column 140
+    SKYLINE_RAY(-992, 257),   // column 141
+    SKYLINE_RAY(-1072, 258),  // column 142
+    SKYLINE_RAY(-1153, 258),  // column 143
+    SKYLINE_RAY(-1233, 258),  // column 144
+    SKYLINE_RAY(-1313, 258),  // column 145
+    SKYLINE_RAY(-1393, 259),  // column 146
+    SKYLINE_RAY(-1473, 259),  // column 147
+    SKYLINE_RAY(-1553, 259),  // column 148
+    SKYLINE_RAY(-1632, 259),  // column 149
+    SKYLINE_RAY(-1711, 260),  // column 150
+    SKYLINE_RAY(-1790, 260),  // column 151
+    SKYLINE_RAY(-1869, 260),  // column 152
+    SKYLINE_RAY(-1948, 261),  // column 153
+    SKYLINE_RAY(-2026, 261),  // column 154
+    SKYLINE_RAY(-2104, 262),  // column 155
+    SKYLINE_RAY(-2182, 262),  // column 156
+    SKYLINE_RAY(-2260, 262),  // column 157
+    SKYLINE_RAY(-2337, 263),  // column 158
+    SKYLINE_RAY(-2414, 263),  // column 159
+    SKYLINE_RAY(-2491, 264),  // column 160
+    SKYLINE_RAY(-2568, 264),  // column 161
+    SKYLINE_RAY(-2644, 265),  // column 162
+    SKYLINE_RAY(-2720, 265),  // column 163
+    SKYLINE_RAY(-2796, 266),  // column 164
+    SKYLINE_RAY(-2871, 266),  // column 165
+    SKYLINE_RAY(-2946, 267),  // column 166
+    SKYLINE_RAY(-3021, 268),  // column 167
+    SKYLINE_RAY(-3095, 268),  // column 168
+    SKYLINE_RAY(-3169, 269),  // column 169
+    SKYLINE_RAY(-3243, 269),  // column 170
+    SKYLINE_RAY(-3316, 270),  // column 171
+    SKYLINE_RAY(-3389, 271),  // column 172
+    SKYLINE_RAY(-3462, 271),  // column 173
+    SKYLINE_RAY(-3535, 272),  // column 174
+    SKYLINE_RAY(-3606, 273),  // column 175
+    SKYLINE_RAY(-3678, 273),  // column 176
+    SKYLINE_RAY(-3749, 274),  // column 177
+    SKYLINE_RAY(-3820, 275),  // column 178
+    SKYLINE_RAY(-3891, 276),  // column 179
+    SKYLINE_RAY(-3961, 276),  // column 180
+    SKYLINE_RAY(-4031, 277),  // column 181
+    SKYLINE_RAY(-4100, 278),  // column 182
+    SKYLINE_RAY(-4169, 279),  // column 183
+    SKYLINE_RAY(-4238, 279),  // column 184
+    SKYLINE_RAY(-4306, 280),  // column 185
+    SKYLINE_RAY(-4374, 281),  // column 186
+    SKYLINE_RAY(-4441, 282),  // column 187
+    SKYLINE_RAY(-4508, 283),  // column 188
+    SKYLINE_RAY(-4575, 284),  // column 189
+    SKYLINE_RAY(-4641, 284),  // column 190
+    SKYLINE_RAY(-4707, 285),  // column 191
+    SKYLINE_RAY(-4772, 286),  // column 192
+    SKYLINE_RAY(-4837, 287),  // column 193
+    SKYLINE_RAY(-4902, 288),  // column 194
+    SKYLINE_RAY(-4966, 289),  // column 195
+    SKYLINE_RAY(-5030, 290),  // column 196
+    SKYLINE_RAY(-5093, 291),  // column 197
+    SKYLINE_RAY(-5156, 292),  // column 198
+    SKYLINE_RAY(-5218, 293),  // column 199
+    SKYLINE_RAY(-5280, 294),  // column 200
+    SKYLINE_RAY(-5342, 295),  // column 201
+    SKYLINE_RAY(-5403, 296),  // column 202
+    SKYLINE_RAY(-5464, 297),  // column 203
+    SKYLINE_RAY(-5525, 298),  // column 204
+    SKYLINE_RAY(-5585, 299),  // column 205
+    SKYLINE_RAY(-5644, 300),  // column 206
+    SKYLINE_RAY(-5704, 301),  // column 207
+    SKYLINE_RAY(-5762, 302),  // column 208
+    SKYLINE_RAY(-5821, 303),  // column 209
+    SKYLINE_RAY(-5879, 304),  // column 210
+    SKYLINE_RAY(-5936, 305),  // column 211
+    SKYLINE_RAY(-5994, 306),  // column 212
+    SKYLINE_RAY(-6050, 307),  // column 213
+    SKYLINE_RAY(-6107, 308),  // column 214
+    SKYLINE_RAY(-6163, 310),  // column 215
+    SKYLINE_RAY(-6218, 311),  // column 216
+    SKYLINE_RAY(-6273, 312),  // column 217
+    SKYLINE_RAY(-6328, 313),  // column 218
+    SKYLINE_RAY(-6382, 314),  // column 219
+    SKYLINE_RAY(-6436, 315),  // column 220
+    SKYLINE_RAY(-6490, 316),  // column 221
+    SKYLINE_RAY(-6543, 318),  // column 222
+    SKYLINE_RAY(-6596, 319),  // column 223
+    SKYLINE_RAY(-6648, 320),  // column 224
+    SKYLINE_RAY(-6700, 321),  // column 225
+    SKYLINE_RAY(-6751, 322),  // column 226
+    SKYLINE_RAY(-6803, 324),  // column 227
+    SKYLINE_RAY(-6853, 325),  // column 228
+    SKYLINE_RAY(-6904, 326),  // column 229
+    SKYLINE_RAY(-6954, 327),  // column 230
+    SKYLINE_RAY(-7004, 329),  // column 231
+    SKYLINE_RAY(-7053, 330),  // column 232
+    SKYLINE_RAY(-7102, 331),  // column 233
+    SKYLINE_RAY(-7150, 332),  // column 234
+    SKYLINE_RAY(-7198, 334),  // column 235
+    SKYLINE_RAY(-7246, 335),  // column 236
+    SKYLINE_RAY(-7294, 336),  // column 237
+    SKYLINE_RAY(-7341, 338),  // column 238
+    SKYLINE_RAY(-7387, 339),  // column 239
+};
+#endif
+
+const struct QualityPreset gQualityPresets[QUALITY_PRESET_COUNT] =
+{
+    //                 name    draw distance  bands {end, step}
+    [QUALITY_HIGH]   = {"high",   512, {{64, 1}, {128, 2}, {256, 4}, {512, 8}}},
+    [QUALITY_NORMAL] = {"normal", 512, {{128, 2}, {256, 4}, {512, 8}}},
+    [QUALITY_LOW]    = {"low",    512, {{64, 2}, {128, 4}, {256, 8}, {512, 16}}},
+    [QUALITY_LOWEST] = {"lowest", 384, {{64, 4}, {128, 8}, {384, 16}}},
+};
+
+const struct Resolution gResolutions[RESOLUTION_COUNT] =
+{
+    [RESOLUTION_PAIRED]       = {"240x160", 240, 160},
+    [RESOLUTION_FULL]         = {"120x160", 120, 160},
+    [RESOLUTION_HALF_AREA]    = {"80x106",   80, 106},
+    [RESOLUTION_QUARTER_AREA] = {"60x80",    60,  80},
+};
+
+// Returns the level of the max-height pyramid to use for runs at slice z
+// with raySpacing (see render_c)
+static inline int heightmax_level(u32 z, u32 raySpacing)
+{
+    u32 reach = z * raySpacing / 2;
+    int level = HEIGHTMAX_MIN_LEVEL;
+
+    // a run spans at most 7 * reach / 64 texels, which fits in 2^L for
+    // reach <= 8 << L
+    while (level < HEIGHTMAX_MAX_LEVEL && reach > (8u << level))
+        level++;
+    return level;
+}
+
+static inline const u8 *heightmax_level_data(int level)
+{
+    const u8 *data = heightmax_bin;
+    int l;
+
+    for (l = HEIGHTMAX_MIN_LEVEL; l < level; l++)
+        data += (1024 >> l) * (1024 >> l);
+    return data;
+}
+
+// Returns the terrain mip level to sample at slice z
+static inline int terrain_mip_level(u32 z)
+{
+    int level = 0;
+
+    while (level < TERRAIN_MIP_LEVELS && z >= (128u << level))
+        level++;
+    return level;
+}
+
+static inline const u8 *terrain_mip_data(int level)
+{
+    if (level == 0)
+        return terrain_bin;
+    return terrainmip_bin + (TERRAIN_PITCH - (2 * TERRAIN_PITCH >> level)) * 2;
+}
+
+// Returns the RGB555 colors of a terrain mip level, laid out like its texels
+static inline const u16 *terrain_mip_colors(int level)
+{
+    const u8 *colors = colormap555_bin;
+
+    if (level != 0)
+        colors += TERRAIN_PITCH * TERRAIN_PITCH * 2 + (TERRAIN_PITCH - (2 * TERRAIN_PITCH >> level)) * 2;
+    return (const u16 *)colors;
+}
+
+void render_init(void)
+{
+    const u8 *top = heightmax_level_data(HEIGHTMAX_MAX_LEVEL);
+    int i;
+
+    // The top level of the pyramid covers the whole map
+    terrainPeakHeight = 0;
+    for (i = 0; i < (1024 >> HEIGHTMAX_MAX_LEVEL) * (1024 >> HEIGHTMAX_MAX_LEVEL); i++)
+    {
+        if (top[i] > terrainPeakHeight)
+            terrainPeakHeight = top[i];
+    }
+
+    render_set_quality(QUALITY_DEFAULT);
+}
+
+// Builds zSchedule from a quality preset
+void render_set_quality(int preset)
+{
+    const struct QualityPreset *quality = &gQualityPresets[preset];
+    u32 drawDistance = quality->drawDistance;
+    u32 z = 1;
+    int band = 0;
+    int n = 0;
+
+    if (drawDistance > MAX_DRAW_DISTANCE)
+        drawDistance = MAX_DRAW_DISTANCE;
+    while (z < drawDistance && n < MAX_Z_SLICES)
+    {
+        zSchedule.slices[n].z = z;
+        // Compute fixed point inverse
+        zSchedule.slices[n].inverse = (1 << 16) / z;
+        n++;
+        while (band < MAX_Z_BANDS - 1 && z >= quality->bands[band].end)
+            band++;
+        z += quality->bands[band].step;
+    }
+    zSchedule.slices[n].z = 0;
+    zSchedule.farInverse = zSchedule.slices[n - 1].inverse;
+    renderQuality = preset;
+}
+
+#ifdef HAVE_SKYLINE
+// Samples the terrain into direction along the ray (rayX, rayY) from the
+// camera at the slices from first on, taken as distances along it. Runs
+// every frame in SKYLINE builds, so it lives in IWRAM with the renderers.
+static RENDER_CODE void sample_skyline_ray(struct SkylineDirection *direction, fixed_t rayX, fixed_t rayY,
+    const struct ZSlice *first)
+{
+    fixed_t cameraX = camera.x;
+    fixed_t cameraY = camera.y;
+    s32 cameraHeight = camera.height;
+    s32 highest = 0x7FFFFFFF;  // top of the samples so far, relative to the horizon
+    u32 count = 0;
+    const struct ZSlice *slice;
+
+    for (slice = first; slice->z != 0 && count < SKYLINE_MAX_SPANS; slice++)
+    {
+        u32 z = slice->z;
+        int mip = terrain_mip_level(z);
+        const u8 *texels = terrain_mip_data(mip);
+        u32 texelMask = (1024 >> mip) - 1;
+        fixed_t x = (cameraX + rayX * (s32)z) >> mip;
+        fixed_t y = (cameraY + rayY * (s32)z) >> mip;
+        u32 index = ((y >> 16) & texelMask) * TERRAIN_PITCH + ((x >> 16) & texelMask);
+        u32 height = texels[index * 2 + 1];
+        s32 top = ((cameraHeight - (s32)height) * (s32)slice->inverse) >> 9;
+
+        if (top < highest)
+        {
+            highest = top;
+            direction->spans[count++] = height | (texels[index * 2] << 8) | (slice->inverse << 16);
+        }
+    }
+    direction->count = count;
+}
+
+// Rebuilds skyline direction n for the current camera from the slices of
+// zSchedule from first on, which are at or beyond renderSkylineZ
+static void build_skyline_direction(int n, const struct ZSlice *first)
+{
+    // the unit vector of the direction, in the camera's convention (forward
+    // is (-sin(yaw), -cos(yaw))). fixed_sin steps every two directions, so
+    // the ones in between take the mean of the steps on either side.
+    int yaw = n << SKYLINE_DIRECTION_SHIFT;
+    int half = 1 << (SKYLINE_DIRECTION_SHIFT - 1);
+    fixed_t rayX = -(fixed_sin(yaw) + fixed_sin(yaw + half)) >> 1;
+    fixed_t rayY = -(fixed_cos(yaw) + fixed_cos(yaw + half)) >> 1;
+
+    sample_skyline_ray(&skyline[n], rayX, rayY, first);
+}
+
+static const struct ZSlice *skyline_first_slice(void)
+{
+    const struct ZSlice *slice = zSchedule.slices;
+
+    while (slice->z != 0 && slice->z < renderSkylineZ)
+        slice++;
+    return slice;
+}
+
+// Rebuilds every direction of skyline
+void render_build_skyline(void)
+{
+    const struct ZSlice *first = skyline_first_slice();
+    int n;
+
+    for (n = 0; n < SKYLINE_DIRECTIONS; n++)
+        build_skyline_direction(n, first);
+    sSkylineCamera = camera;
+    sSkylineQuality = renderQuality;
+    sSkylineViewLeft = 0;
+}
+
+// Rebuilds the next viewCount directions of skyline in the view, which it
+// goes through from right to left, and the next backgroundCount directions
+// around the rest of the circle. Returns nonzero until every direction of
+// the view has been rebuilt since the camera or the quality last changed.
+int render_update_skyline(int viewCount, int backgroundCount)
+{
+    const struct ZSlice *first = skyline_first_slice();
+    // the renderers turn the view in steps of 256 yaw units (see fixed_sin)
+    int right = (((camera.yaw & 0xFF00) + skylineRays[SCREEN_WIDTH - 1]) & 0xFFFF) >> SKYLINE_DIRECTION_SHIFT;
+    // directions spanned by the view
+    int viewDirections = ((s16)skylineRays[0] - (s16)skylineRays[SCREEN_WIDTH - 1]) / (1 << SKYLINE_DIRECTION_SHIFT) + 2;
+
+    // the directions that have come into view may have been built for an
+    // older position too
+    if (camera.x != sSkylineCamera.x
+     || camera.y != sSkylineCamera.y
+     || camera.height != sSkylineCamera.height
+     || (camera.yaw & 0xFF00) != (sSkylineCamera.yaw & 0xFF00)
+     || renderQuality != sSkylineQuality)
+    {
+        sSkylineCamera = camera;
+        sSkylineQuality = renderQuality;
+        sSkylineViewLeft = viewDirections;
+    }
+
+    while (viewCount-- > 0)
+    {
+        build_skyline_direction((right + sSkylineCursor) & (SKYLINE_DIRECTIONS - 1), first);
+        if (++sSkylineCursor >= viewDirections)
+            sSkylineCursor = 0;
+        if (sSkylineViewLeft > 0)
+            sSkylineViewLeft--;
+    }
+    while (backgroundCount > 0)
+    {
+        int n = sSkylineBackgroundCursor;
+
+        sSkylineBackgroundCursor = (n + 1) & (SKYLINE_DIRECTIONS - 1);
+        if (((n - right) & (SKYLINE_DIRECTIONS - 1)) < viewDirections)
+            continue;  // kept up by the loop above
+        build_skyline_direction(n, first);
+        backgroundCount--;
+    }
+    return sSkylineViewLeft > 0;
+}
+#endif
+
+static inline void draw_vertical_bar(u16 *frame, int x, int top, int bottom, u8 color)
+{
+    int y;
+    //if (top < 0)
+    //    top = 0;
+    //if (bottom < top)
+   //     return;
+    //if (bottom > 160)
+    //    bottom = 160;
+    //assert(bottom <= 160);
+
+    u16 *dest = frame + top * SCREEN_WIDTH/2 + x;
+    for (y = top; y < bottom; y++)
+    {
+        *dest = color | (color << 8);
+        dest += SCREEN_WIDTH/2;
+    }
+}
+
+// Draws the bars of the two rays of a double-wide column in paired mode,
+// from topA to bottomA in its left pixel and from topB to bottomB in its
+// right one. Rows covered by both bars are written whole, and the other rows
+// keep the pixel of the other ray.
+static inline void draw_bar_pair(u16 *frame, int x, int topA, int bottomA, u8 colorA,
+    int topB, int bottomB, u8 colorB)
+{
+    int top = topA < topB ? topA : topB;
+    int bottom = bottomA > bottomB ? bottomA : bottomB;
+    u16 *dest = frame + top * SCREEN_WIDTH/2 + x;
+    int y;
+
+    for (y = top; y < bottom; y++)
+    {
+        int inA = y >= topA && y < bottomA;
+        int inB = y >= topB && y < bottomB;
+
+        if (inA && inB)
+            *dest = colorA | (colorB << 8);
+        else if (inA)
+            *dest = (*dest & 0xFF00) | colorA;
+        else if (inB)
+            *dest = (*dest & 0x00FF) | (colorB << 8);
+        dest += SCREEN_WIDTH/2;
+    }
+}
+
+RENDER_CODE void render_c(u32 columns, u32 rows)
+{
+    int i;
+    int run;
+    // In paired mode (SCREEN_WIDTH columns) each double-wide column marches
+    // two rays, the second half a column to the right of the first, and
+    // ybuffer[2 * i] and ybuffer[2 * i + 1] are the left and right pixels of
+    // column i
+    int pairs = (columns == SCREEN_WIDTH);
+    /*__attribute__((aligned(4))*/ u8 ybuffer[SCREEN_WIDTH] ALIGN(4);
+    u8 runMax[RUN_COUNT];  // highest ybuffer value in each run of columns
+    // In interlaced mode only every other column is drawn, so ybuffer[i] is
+    // column i + field and the columns of the other field are closed
+    int field = (renderInterlaced && !pairs) ? renderField : 0;
+    int step = (renderInterlaced && !pairs) ? 2 : 1;
+    u16 *frame = frameBuffer + field;
+    // The columns cover the same field of view at every width, and the
+    // projection is scaled down to the rows. Columns past the last one are
+    // closed.
+    if (pairs)
+        columns = SCREEN_WIDTH/2;
+    u32 raySpacing = SCREEN_WIDTH / columns;
+    s32 rowScale = RENDER_ROW_SCALE(rows);
+    s32 horizon = (camera.horizon * rowScale) >> 8;
+    int runCount = (columns + RUN_WIDTH - 1) / RUN_WIDTH;
+    // distance from the first to the last ray of a run, in half steps
+    int runSpan = pairs ? 2 * RUN_WIDTH - 1 : 2 * (RUN_WIDTH / step - 1);
+    // nothing is drawn above windowTop, which moves down to the ground plane
+    // split (see renderPlaneZ) once the slices reach it
+    s32 windowTop = 0;
+    int planeSplit = (renderPlaneZ != 0);
+#ifdef HAVE_SKYLINE
+    u32 skylineZ = (pairs || planeSplit) ? 0 : renderSkylineZ;
+#endif
+
+    /*
+    DmaFill32(3, BG_COLOR|(BG_COLOR<<8)|(BG_COLOR<<16)|(BG_COLOR<<24), frameBuffer, 160 * 240);
+
+    for (i = 0; i < SCREEN_WIDTH/2; i++)
+        ybuffer[i] = 160;
+    */
+    for (i = 0; i < SCREEN_WIDTH; i++)
+    {
+        if (pairs)
+            ybuffer[i] = rows;
+        else
+            ybuffer[i] = ((u32)i < columns && i % step == 0) ? rows : 0;
+    }
+    for (run = 0; run < runCount; run++)
+        runMax[run] = rows;
+    renderPlaneRow = 0;
+
+    fixed_t s = camera.sinYaw;
+    fixed_t c = camera.cosYaw;
+    const struct ZSlice *slice;
+    for (slice = zSchedule.slices; slice->z != 0; slice++)
+    {
+        u32 z = slice->z;
+
+        // leave the rows above the terrain drawn so far to the ground plane
+        if (planeSplit && z >= renderPlaneZ)
+        {
+            planeSplit = 0;
+            windowTop = rows;
+            for (i = 0; (u32)i < (pairs ? SCREEN_WIDTH : columns); i += step)
+            {
+                if (ybuffer[i] < windowTop)
+                    windowTop = ybuffer[i];
+            }
+            renderPlaneRow = windowTop;
+        }
+
+#ifdef HAVE_SKYLINE
+        // project the rest of the far field from the skyline instead
+        if (skylineZ != 0 && z >= skylineZ)
+        {
+            for (i = 0; (u32)i < columns; i += step)
+            {
+                u32 ray = skylineRays[(i + field) * raySpacing];
+                const struct SkylineDirection *direction
+                    = &skyline[(u16)((camera.yaw & 0xFF00) + ray) >> SKYLINE_DIRECTION_SHIFT];
+                s32 columnScale = ((ray >> 16) * rowScale) >> 8;
+                u32 n;
+
+                for (n = 0; n < direction->count; n++)
+                {
+                    u32 span = direction->spans[n];
+                    s32 invz = ((span >> 16) * columnScale) >> 8;
+                    s32 height = (((camera.height - (s32)(span & 0xFF)) * invz) >> 9) + horizon;
+
+                    if (height < windowTop)
+                        height = windowTop;
+                    if (height < ybuffer[i])
+                    {
+                        draw_vertical_bar(frame, i, height, ybuffer[i], (u8)(span >> 8));
+                        ybuffer[i] = height;
+                    }
+                }
+            }
+            break;
+        }
+#endif
+
+        fixed_t lx = (-c * z - s * z);
+        fixed_t ly = (s * z - c * z);
+        fixed_t rx = (c * z - s * z);
+        fixed_t ry = (-s * z - c * z);
+        /*
+        fixed_t dx = (rx - lx) / 240;
+        fixed_t dy = (ry - ly) / 240;
+        */
+        // this is less accurate, but faster
+        // (the step between double-wide columns, rounded like render_asm)
+        fixed_t dx = ((rx - lx) * (s32)raySpacing) >> 8;
+        fixed_t dy = ((ry - ly) * (s32)raySpacing) >> 8;
+
+        lx += (camera.x);
+        ly += (camera.y);
+
+        // scale the ray down to the coordinates of the mip level
+        int mip = terrain_mip_level(z);
+        const u8 *texels = terrain_mip_data(mip);
+        u32 texelMask = (1024 >> mip) - 1;
+        lx >>= mip;
+        ly >>= mip;
+        dx >>= mip;
+        dy >>= mip;
+
+        // start at the first column of the field and step over the other one
+        lx += field * dx;
+        ly += field * dy;
+        dx *= step;
+        dy *= step;
+
+        //fixed_t invz = 65536 / z;
+        fixed_t invz = (slice->inverse * rowScale) >> 8;
+
+        // top left corner of the bounding box of a run, relative to its first
+        // sample (the last right ray of a paired run is half a step further)
+        int level = heightmax_level(z, raySpacing);
+        const u8 *heightmax = heightmax_level_data(level);
+        u32 tileMask = (1024 >> level) - 1;
+        fixed_t cornerX = dx < 0 ? (dx * runSpan) >> 1 : 0;
+        fixed_t cornerY = dy < 0 ? (dy * runSpan) >> 1 : 0;
+
+        for (run = 0, i = 0; run < runCount; run++)
+        {
+            u32 tileX = ((lx + cornerX) >> (16 + level - mip)) & tileMask;
+            u32 tileY = ((ly + cornerY) >> (16 + level - mip)) & tileMask;
+            u32 maxHeight = heightmax[tileY * (tileMask + 1) + tileX];
+            s32 top = (((camera.height - (s32)maxHeight) * invz) >> 9) + horizon;
+            int end = i + RUN_WIDTH;
+            u8 newMax = 0;
+
+            // skip the run if nothing in it can rise above the y buffer
+            if (top < windowTop)
+                top = windowTop;
+            if (top >= runMax[run])
+            {
+                lx += dx * (RUN_WIDTH / step);
+                ly += dy * (RUN_WIDTH / step);
+                i = end;
+                continue;
+            }
+
+            if (pairs)
+            {
+                for (; i < end; i++, ly += dy, lx += dx)
+                {
+                    // the right ray is rounded like render_asm
+                    fixed_t lxB = lx + (dx >> 1);
+                    fixed_t lyB = ly + (dy >> 1);
+                    u32 indexA = ((ly >> 16) & texelMask) * TERRAIN_PITCH + ((lx >> 16) & texelMask);
+                    u32 indexB = ((lyB >> 16) & texelMask) * TERRAIN_PITCH + ((lxB >> 16) & texelMask);
+                    s32 heightA = (((camera.height - texels[indexA * 2 + 1]) * invz) >> 9) + horizon;
+                    s32 heightB = (((camera.height - texels[indexB * 2 + 1]) * invz) >> 9) + horizon;
+                    u8 *y = &ybuffer[i * 2];
+
+                    if (heightA < windowTop)
+                        heightA = windowTop;
+                    if (heightB < windowTop)
+                        heightB = windowTop;
+                    if (heightA < y[0] || heightB < y[1])
+                    {
+                        s32 topA = heightA < y[0] ? heightA : y[0];
+                        s32 topB = heightB < y[1] ? heightB : y[1];
+
+                        draw_bar_pair(frame, i, topA, y[0], texels[indexA * 2],
+                            topB, y[1], texels[indexB * 2]);
+                        y[0] = topA;
+                        y[1] = topB;
+                    }
+                    if (y[0] > newMax)
+                        newMax = y[0];
+                    if (y[1] > newMax)
+                        newMax = y[1];
+                }
+                runMax[run] = newMax;
+                continue;
+            }
+
+            // near the camera, neighboring columns often sample the same
+            // texel, so only fetch and project it again when the index changes
+            u32 lastIndex = ~0u;
+            s32 height = 0;
+            u8 color = 0;
+
+            for (; i < end; i += step, ly += dy, lx += dx)
+            {
+                u32 index = ((ly >> 16) & texelMask) * TERRAIN_PITCH + ((lx >> 16) & texelMask);
+                /*
+                u32 index2 = ((ly >> 15) & (1023<<1)) * 1024 + ((lx >> 15) & (1023<<1));
+                assert(index2 == index * 2);
+                */
+                //if ((u32)ly >= 2*1024 << 16 || (u32)lx >= 2*1024 << 16) continue; // bounds
+                if (index != lastIndex)
+                {
+                    lastIndex = index;
+                    // (128 * (camera.height - h) * invz) >> 16, without overflowing for high cameras
+                    height = (((camera.height - texels[index * 2 + 1]) * invz) >> 9) + horizon;
+                    if (height < windowTop)
+                        height = windowTop;
+                    color = texels[index * 2];
+                }
+                if (height < ybuffer[i])
+                {
+                    draw_vertical_bar(frame, i, height, ybuffer[i], color);
+                    ybuffer[i] = height;
+                }
+                if (ybuffer[i] > newMax)
+                    newMax = ybuffer[i];
+            }
+            runMax[run] = newMax;
+        }
+
+        // Stop once every column is closed: no terrain beyond this slice can
+        // rise above the y buffer. The peak projects highest at the far end
+        // of the schedule when the camera is above it, and at this slice
+        // when it is below.
+        s32 peakTop = ((camera.height - (s32)terrainPeakHeight)
+            * (s32)(camera.height >= terrainPeakHeight ? (zSchedule.farInverse * rowScale) >> 8 : invz) >> 9) + horizon;
+        if (peakTop < windowTop)
+            peakTop = windowTop;
+        for (run = 0; run < runCount; run++)
+        {
+            if (runMax[run] > peakTop)
+                break;
+        }
+        if (run == runCount)
+            break;
+    }
+
+    // The back buffer is not cleared, so fill the sky above the terrain,
+    // down from windowTop. Rows above the top of the terrain in every column
+    // are filled whole (CpuFastFill works in blocks of 8 words, so an even
+    // number of rows).
+    u32 skyBottom = rows;
+    for (i = 0; (u32)i < (pairs ? SCREEN_WIDTH : columns); i += step)
+    {
+        if (ybuffer[i] < skyBottom)
+            skyBottom = ybuffer[i];
+    }
+    skyBottom = windowTop + ((skyBottom - windowTop) & ~1);
+    if (skyBottom != (u32)windowTop)
+        CpuFastFill(BG_COLOR|(BG_COLOR<<8)|(BG_COLOR<<16)|(BG_COLOR<<24), frameBuffer + windowTop * SCREEN_WIDTH/2,
+            (skyBottom - windowTop) * 240);
+    for (i = 0; (u32)i < columns; i++)
+    {
+        if (pairs)
+            draw_bar_pair(frame, i, skyBottom, ybuffer[i * 2], BG_COLOR,
+                skyBottom, ybuffer[i * 2 + 1], BG_COLOR);
+        else
+            draw_vertical_bar(frame, i, skyBottom, ybuffer[i], BG_COLOR);
+    }
+}
+
+RENDER_CODE void render_mode5_c(void)
+{
+    int i;
+    int run;
+    u8 ybuffer[MODE5_WIDTH] ALIGN(4);
+    u8 runMax[MODE5_WIDTH / RUN_WIDTH];  // highest ybuffer value in each run of columns
+    s32 rowScale = RENDER_ROW_SCALE(MODE5_HEIGHT);
+    s32 horizon = (camera.horizon * rowScale) >> 8;
+
+    for (i = 0; i < MODE5_WIDTH; i++)
+        ybuffer[i] = MODE5_HEIGHT;
+    for (run = 0; run < MODE5_WIDTH / RUN_WIDTH; run++)
+        runMax[run] = MODE5_HEIGHT;
+
+    fixed_t s = camera.sinYaw;
+    fixed_t c = camera.cosYaw;
+    const struct ZSlice *slice;
+    for (slice = zSchedule.slices; slice->z != 0; slice++)
+    {
+        u32 z = slice->z;
+        fixed_t lx = (-c * z - s * z);
+        fixed_t ly = (s * z - c * z);
+        fixed_t rx = (c * z - s * z);
+        fixed_t ry = (-s * z - c * z);
+        // MODE5_WIDTH rays across the SCREEN_WIDTH/256 of the view that
+        // render_c covers, 1.5 of its pixels apart
+        fixed_t dx = ((rx - lx) * 3) >> 9;
+        fixed_t dy = ((ry - ly) * 3) >> 9;
+
+        lx += (camera.x);
+        ly += (camera.y);
+
+        // scale the ray down to the coordinates of the mip level
+        int mip = terrain_mip_level(z);
+        const u8 *texels = terrain_mip_data(mip);
+        const u16 *colors = terrain_mip_colors(mip);
+        u32 texelMask = (1024 >> mip) - 1;
+        lx >>= mip;
+        ly >>= mip;
+        dx >>= mip;
+        dy >>= mip;
+
+        fixed_t invz = (slice->inverse * rowScale) >> 8;
+
+        // top left corner of the bounding box of a run, relative to its first
+        // sample. The rays are closer together than with a ray spacing of 2,
+        // so its levels cover the runs.
+        int level = heightmax_level(z, 2);
+        const u8 *heightmax = heightmax_level_data(level);
+        u32 tileMask = (1024 >> level) - 1;
+        fixed_t cornerX = dx < 0 ? dx * (RUN_WIDTH - 1) : 0;
+        fixed_t cornerY = dy < 0 ? dy * (RUN_WIDTH - 1) : 0;
+
+        for (run = 0, i = 0; run < MODE5_WIDTH / RUN_WIDTH; run++)
+        {
+            u32 tileX = ((lx + cornerX) >> (16 + level - mip)) & tileMask;
+            u32 tileY = ((ly + cornerY) >> (16 + level - mip)) & tileMask;
+            u32 maxHeight = heightmax[tileY * (tileMask + 1) + tileX];
+            s32 top = (((camera.height - (s32)maxHeight) * invz) >> 9) + horizon;
+            int end = i + RUN_WIDTH;
+            u8 newMax = 0;
+
+            // skip the run if nothing in it can rise above the y buffer
+            if (top < 0)
+                top = 0;
+            if (top >= runMax[run])
+            {
+                lx += dx * RUN_WIDTH;
+                ly += dy * RUN_WIDTH;
+                i = end;
+                continue;
+            }
+
+            for (; i < end; i++, ly += dy, lx += dx)
+            {
+                u32 index = ((ly >> 16) & texelMask) * TERRAIN_PITCH + ((lx >> 16) & texelMask);
+                s32 height = (((camera.height - texels[index * 2 + 1]) * invz) >> 9) + horizon;
+
+                if (height < 0)
+                    height = 0;
+                if (height < ybuffer[i])
+                {
+                    u16 color = colors[index];
+                    u16 *dest = frameBuffer + height * MODE5_WIDTH + i;
+                    int y;
+
+                    for (y = height; y < ybuffer[i]; y++, dest += MODE5_WIDTH)
+                        *dest = color;
+                    ybuffer[i] = height;
+                }
+                if (ybuffer[i] > newMax)
+                    newMax = ybuffer[i];
+            }
+            runMax[run] = newMax;
+        }
+
+        // Stop once every column is closed (see render_c)
+        s32 peakTop = ((camera.height - (s32)terrainPeakHeight)
+            * (s32)(camera.height >= terrainPeakHeight ? (zSchedule.farInverse * rowScale) >> 8 : invz) >> 9) + horizon;
+        if (peakTop < 0)
+            peakTop = 0;
+        for (run = 0; run < MODE5_WIDTH / RUN_WIDTH; run++)
+        {
+            if (runMax[run] > peakTop)
+                break;
+        }
+        if (run == MODE5_WIDTH / RUN_WIDTH)
+            break;
+    }
+
+    // Fill the sky like render_c. A Mode 5 row is a whole number of
+    // CpuFastFill blocks.
+    u32 skyBottom = MODE5_HEIGHT;
+    for (i = 0; i < MODE5_WIDTH; i++)
+    {
+        if (ybuffer[i] < skyBottom)
+            skyBottom = ybuffer[i];
+    }
+    if (skyBottom != 0)
+        CpuFastFill16(mode5SkyColor, frameBuffer, skyBottom * MODE5_WIDTH * 2);
+    for (i = 0; i < MODE5_WIDTH; i++)
+    {
+        u16 *dest = frameBuffer + skyBottom * MODE5_WIDTH + i;
+        u32 y;
+
+        for (y = skyBottom; y < ybuffer[i]; y++, dest += MODE5_WIDTH)
+            *dest = mode5SkyColor;
+    }
+}
+
+RENDER_CODE void copy_field_c(u16 *dest, const u16 *src, int field)
+{
+    int i;
+
+    for (i = field; i < SCREEN_WIDTH/2 * SCREEN_HEIGHT; i += 2)
+        dest[i] = src[i];
+}
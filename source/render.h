@@ -0,0 +1,250 @@
+#ifndef GUARD_RENDER_H
+#define GUARD_RENDER_H
+
+#include <gba_base.h>
+
+#include "trig.h"
+
+#define BG_COLOR 251
+
+// Renderers run from IWRAM as ARM code. The host build compiles them as
+// plain functions.
+#ifdef HOST_BUILD
+#define RENDER_CODE
+#else
+#define RENDER_CODE __attribute__((section(".iwram"), target("arm"), long_call))
+#endif
+
+// The layout of this struct must match the o_camera_* offsets in renderer.s
+struct Camera
+{
+    /*0x00*/ fixed_t x;
+    /*0x04*/ fixed_t y;
+    /*0x08*/ s32 height;
+    /*0x0C*/ s32 horizon;
+    /*0x10*/ fixed_t sinYaw;
+    /*0x14*/ fixed_t cosYaw;
+    /*0x18*/ s16 yaw;
+};
+
+extern struct Camera camera;
+
+// buffer to write to (this is the back buffer)
+extern u16 *frameBuffer;
+
+// Presents the back buffer and makes the other page the new back buffer
+void swap_buffers(void);
+
+extern u8 terrainPeakHeight;  // highest point of the terrain
+
+// The renderers draw the slices listed in zSchedule, nearest first. It is
+// built from one of gQualityPresets by render_set_quality.
+struct ZSlice
+{
+    /*0x00*/ u32 z;
+    /*0x04*/ u32 inverse;  // (1 << 16) / z
+};
+
+#define MAX_DRAW_DISTANCE 512  // the farthest z the max-height pyramid covers
+#define MAX_Z_SLICES 192
+
+// The layout of this struct must match the o_schedule_* offsets in renderer.s
+struct ZSchedule
+{
+    /*0x00*/ u32 farInverse;  // inverse of the last z
+    /*0x04*/ struct ZSlice slices[MAX_Z_SLICES + 1];  // terminated by z = 0
+};
+
+extern struct ZSchedule zSchedule;
+
+// Slices start at z = 1 and step by the step of the first band that ends
+// beyond the current z, up to the draw distance
+struct ZBand
+{
+    u16 end;
+    u16 step;
+};
+
+#define MAX_Z_BANDS 4
+
+struct QualityPreset
+{
+    const char *name;
+    u16 drawDistance;
+    struct ZBand bands[MAX_Z_BANDS];
+};
+
+enum
+{
+    QUALITY_HIGH,
+    QUALITY_NORMAL,
+    QUALITY_LOW,
+    QUALITY_LOWEST,
+    QUALITY_PRESET_COUNT,
+};
+
+#define QUALITY_DEFAULT QUALITY_NORMAL
+
+extern const struct QualityPreset gQualityPresets[QUALITY_PRESET_COUNT];
+extern int renderQuality;  // preset zSchedule was built from
+
+// Columns are tested against the max-height pyramid (heightmax.bin, written
+// by generate_terrain_map.py) in runs of RUN_WIDTH. Level L of the pyramid
+// has a byte per 2^L x 2^L tile of the terrain holding the highest point of
+// that tile and its right, lower and lower-right neighbors, so one lookup at
+// the top left corner of a run's bounding box bounds the whole run as long as
+// the run spans no more than a tile. A run at slice z spans at most
+// 7z/64 * raySpacing/2 texels on each axis (7.5z/64 in paired mode, see
+// render_c), which the top level covers up to the draw distance for a ray
+// spacing of up to 8.
+#define RUN_WIDTH 8
+#define RUN_COUNT (SCREEN_WIDTH/2/RUN_WIDTH)
+#define HEIGHTMAX_MIN_LEVEL 2
+#define HEIGHTMAX_MAX_LEVEL 8
+
+// Far slices sample prefiltered mip levels of the terrain (terrainmip.bin,
+// written by generate_terrain_map.py) instead of the full map, which aliases
+// once a column spans several texels. Level L averages 2^L x 2^L texels and
+// is used from z = 64 << L on, where a column spans 2^L texels. All levels
+// are stored in rows of TERRAIN_PITCH texels like the full map, level L from
+// column TERRAIN_PITCH - (2 * TERRAIN_PITCH >> L) on, so the renderers index
+// them the same way after scaling the ray coordinates down by 2^L.
+#define TERRAIN_PITCH 1024
+#define TERRAIN_MIP_LEVELS 3
+
+// Interlaced rendering. While renderInterlaced is set, the renderers only
+// draw the double-wide columns of field renderField (0 for the even columns,
+// 1 for the odd ones), and copy_field_* brings the other field over from the
+// previous frame.
+extern int renderInterlaced;
+extern int renderField;
+
+// Span list back end of render_asm. While renderSpanList is set, render_asm
+// lists each bar under its top row instead of drawing it, then fills the
+// frame a whole row at a time with ldmia/stmia copies from a row buffer that
+// carries each column's color down from the row above. The frame is the same
+// either way, so render_c has no equivalent. It is ignored when interlaced or
+// in paired mode, and if the list fills up, it is rasterized right there and
+// the rest of the frame is drawn directly.
+extern int renderSpanList;
+
+// Column strip back end of render_asm. While renderColumnStrips is set,
+// render_asm draws each column as a strip of a byte per row in an IWRAM
+// buffer, so bars become sequential word stores, and transposes the strips
+// into frameBuffer at the end. The buffer holds 80 columns, so wider frames
+// are drawn in bands of columns with a pass over zSchedule each. The frame
+// is the same, and it is ignored when interlaced or in paired mode like
+// renderSpanList, which it takes precedence over.
+extern int renderColumnStrips;
+
+// Ground plane split (HYBRID builds, see hybrid.h). While renderPlaneZ is
+// nonzero, the renderers hand the far field above the near terrain to the
+// affine ground plane: at the first slice at or beyond renderPlaneZ they set
+// renderPlaneRow to the top row of the terrain drawn so far, and draw the
+// rest of the slices and the sky only below it, leaving the rows above
+// untouched. renderPlaneRow is 0 if the frame was done before that slice.
+// render_asm ignores renderPlaneZ with the span list and column strip back
+// ends.
+extern u32 renderPlaneZ;
+extern int renderPlaneRow;
+
+// Skyline impostor (SKYLINE builds, see the Makefile). skyline holds the far
+// field around the camera in SKYLINE_DIRECTIONS directions: for each, the
+// terrain samples along its ray from renderSkylineZ on that rose above the
+// ones before them when it was built, nearest first. While renderSkylineZ is
+// nonzero, the renderers stop at the first slice at or beyond it, and
+// project the samples of each column's direction with the current camera
+// height and horizon instead of marching the rest of the slices.
+// render_update_skyline rebuilds a few directions of the view per call, so
+// the far field trails the camera by a few frames when it moves, and a few
+// of the rest of the circle, so that it is not as far behind when it turns.
+// renderSkylineZ is ignored in paired mode, with the ground plane split and
+// by the span list and column strip back ends. The impostor is only compiled
+// into the builds that use it (HAVE_SKYLINE).
+#if defined(SKYLINE) || defined(BENCHMARK) || defined(HOST_BUILD)
+#define HAVE_SKYLINE
+#endif
+
+#define SKYLINE_DIRECTIONS 512
+#define SKYLINE_DIRECTION_SHIFT 7  // yaw units per direction (65536 / SKYLINE_DIRECTIONS)
+#define SKYLINE_MAX_SPANS 31       // so that a direction is 128 bytes
+#define SKYLINE_Z 256              // renderSkylineZ of SKYLINE builds
+#define SKYLINE_UPDATE_DIRECTIONS 8      // directions of the view rebuilt per frame in SKYLINE builds
+#define SKYLINE_BACKGROUND_DIRECTIONS 2  // and of the rest of the circle
+
+// The size of this struct must match SKYLINE_DIRECTION_SIZE_SHIFT in
+// renderer.s
+struct SkylineDirection
+{
+    /*0x00*/ u32 count;
+    /*0x04*/ u32 spans[SKYLINE_MAX_SPANS];  // height | (color << 8) | (((1 << 16) / z) << 16)
+};
+
+#ifdef HAVE_SKYLINE
+extern struct SkylineDirection skyline[SKYLINE_DIRECTIONS];
+// For each pixel column of the screen, the yaw of the ray through its left
+// edge relative to the view, biased by half a direction, in the low half,
+// and the secant of the angle between them (8.8 fixed point) in the high half
+extern const u32 skylineRays[];  // SCREEN_WIDTH entries
+extern u32 renderSkylineZ;
+
+void render_build_skyline(void);
+int render_update_skyline(int viewCount, int backgroundCount);
+#endif
+
+// Internal resolutions. The renderers draw `columns` double-wide columns
+// (which must divide SCREEN_WIDTH) and `rows` rows into the top left of
+// frameBuffer, covering the same field of view as the full resolution, and
+// BG2 stretches them back to the screen with PA = RENDER_COLUMN_SCALE(columns)
+// and PD = RENDER_ROW_SCALE(rows).
+//
+// SCREEN_WIDTH columns selects paired mode: the double-wide columns march two
+// rays each, one per pixel, and write both pixels with one strh where their
+// bars overlap. It is never interlaced (renderInterlaced is ignored).
+struct Resolution
+{
+    const char *name;
+    u8 columns;
+    u8 rows;
+};
+
+enum
+{
+    RESOLUTION_PAIRED,
+    RESOLUTION_FULL,
+    RESOLUTION_HALF_AREA,
+    RESOLUTION_QUARTER_AREA,
+    RESOLUTION_COUNT,
+};
+
+extern const struct Resolution gResolutions[RESOLUTION_COUNT];
+
+// 8.8 fixed point scales from the screen to the rendered area
+#define RENDER_COLUMN_SCALE(columns) ((columns) == SCREEN_WIDTH ? 256 : ((columns) << 8) / (SCREEN_WIDTH/2))
+#define RENDER_ROW_SCALE(rows) (((rows) << 8) / SCREEN_HEIGHT)
+
+void render_init(void);
+void render_set_quality(int preset);
+RENDER_CODE void render_c(u32 columns, u32 rows);
+extern RENDER_CODE void render_asm(u32 columns, u32 rows);
+
+// Mode 5 renderer (MODE5 builds, see the Makefile). It draws MODE5_WIDTH x
+// MODE5_HEIGHT true-color pixels into the Mode 5 page at frameBuffer, a ray
+// per pixel across the same field of view as the Mode 4 renderers, with the
+// RGB555 colors of colormap555.bin (written by generate_terrain_map.py)
+// instead of the palette, and the sky in mode5SkyColor. BG2 stretches the
+// page to the screen with PA = MODE5_COLUMN_SCALE and PD = MODE5_ROW_SCALE.
+#define MODE5_WIDTH  160
+#define MODE5_HEIGHT 128
+#define MODE5_COLUMN_SCALE ((MODE5_WIDTH << 8) / SCREEN_WIDTH)
+#define MODE5_ROW_SCALE RENDER_ROW_SCALE(MODE5_HEIGHT)
+
+extern u16 mode5SkyColor;
+
+RENDER_CODE void render_mode5_c(void);
+
+// Copies the columns of one field from one 240x160 page to another
+RENDER_CODE void copy_field_c(u16 *dest, const u16 *src, int field);
+extern RENDER_CODE void copy_field_asm(u16 *dest, const u16 *src, int field);
+
+#endif // GUARD_RENDER_H
@@ -15,6 +15,128 @@
     .set CPUSET_32BIT,     (1 << 26)
     .set CPUSET_SRC_FIXED, (1 << 24)
 
+@ These must match render.h
+    .set RUN_WIDTH, 8
+    .set RUN_WIDTH_SHIFT, 3
+
+    .set RUN_COUNT, (SCREEN_WIDTH/2/RUN_WIDTH)
+
+    .set SIZEOF_LEVEL, 20   @ size of a heightmaxLevels entry
+
+    .set TERRAIN_PITCH, 1024
+    .set TERRAIN_MIP_LEVELS, 3
+
+@ Columns drawn into stripBuffer per pass in column strip mode (see
+@ local_strips). The span list shares the buffer.
+    .set STRIP_COLUMNS, 80
+
+@ Bars the span list holds before it is rasterized early (see local_spans)
+    .set SPAN_LIST_CAPACITY, (STRIP_COLUMNS * SCREEN_HEIGHT / 4)
+
+@ The skyline impostor is only assembled into the builds that use it (see
+@ HAVE_SKYLINE in render.h)
+#if defined(SKYLINE) || defined(BENCHMARK)
+#define HAVE_SKYLINE
+#endif
+
+@ These must match the skyline impostor in render.h
+    .set SKYLINE_DIRECTION_SHIFT, 7
+    .set SKYLINE_DIRECTION_SIZE_SHIFT, 7    @ log2 of sizeof(struct SkylineDirection)
+
+@ Where DRAW_COLUMNS puts its bars
+    .set TARGET_FRAME,  0
+    .set TARGET_SPANS,  1
+    .set TARGET_STRIPS, 2
+
+@ Sets \rd to the highest ybuffer value of the run starting at \rbase, which
+@ has \width entries
+    .macro RUN_MAX rd, rbase, rtmp, width=RUN_WIDTH
+    ldrb \rd, [\rbase]
+    .set RUN_MAX_ENTRY, 1
+    .rept \width - 1
+        ldrb \rtmp, [\rbase, #RUN_MAX_ENTRY]
+        cmp \rtmp, \rd
+        movhi \rd, \rtmp
+        .set RUN_MAX_ENTRY, RUN_MAX_ENTRY + 1
+    .endr
+    .endm
+
+@ Writes \count (at least 1) pixels of \color, a doubled palette index, down
+@ the screen from \dest. Clobbers \dest, \count and \tmp.
+    .macro DRAW_BAR color, dest, count, tmp
+.if 0
+
+  1:
+    strh \color, [\dest], #SCREEN_WIDTH
+    subs \count, #1
+    bgt 1b
+
+.else
+
+    @ Simple "Duff's Device" to optimize this innermost loop
+    .set ITERATIONS_PER_LOOP, 16    @ must be a power of two
+    and \tmp, \count, #(ITERATIONS_PER_LOOP - 1)
+    rsb \tmp, \tmp, #ITERATIONS_PER_LOOP
+    add pc, pc, \tmp, lsl #2
+    nop
+  1:
+    @ repeat the strh instruction ITERATIONS_PER_LOOP times
+    .rept ITERATIONS_PER_LOOP
+        strh \color, [\dest], #SCREEN_WIDTH
+    .endr
+    subs \count, #ITERATIONS_PER_LOOP
+    bge 1b
+
+.endif
+    .endm
+
+@ Writes \count (at least 1) pixels of \color down the screen from \dest like
+@ DRAW_BAR, but only into the bytes of each halfword cleared in \keep (0xFF00
+@ to write the left pixel, 0x00FF for the right one). Clobbers \dest, \count
+@ and \tmp.
+    .macro DRAW_BAR_BYTE color, keep, dest, count, tmp
+  1:
+    ldrh \tmp, [\dest]
+    eor \tmp, \tmp, \color
+    and \tmp, \tmp, #\keep
+    eor \tmp, \tmp, \color         @ \tmp = (\tmp & \keep) | (\color & ~\keep)
+    strh \tmp, [\dest], #SCREEN_WIDTH
+    subs \count, #1
+    bgt 1b
+    .endm
+
+@ Writes \count (at least 1) bytes of \color, a palette index, from \dest on:
+@ bytes up to a word boundary, then pairs of words with stmia. \tmp must be
+@ a higher register than \color. Clobbers \color, \dest, \count and \tmp.
+    .macro DRAW_STRIP color, dest, count, tmp
+    orr \color, \color, \color, lsl #8
+    orr \color, \color, \color, lsl #16
+  1:
+    tst \dest, #3
+    beq 2f
+    strb \color, [\dest], #1
+    subs \count, #1
+    bne 1b
+    b 4f
+  2:
+    mov \tmp, \color
+    subs \count, #8
+    blt 3f
+  5:
+    stmia \dest!, {\color, \tmp}
+    subs \count, #8
+    bge 5b
+  3:
+    @ \count is now the bytes left - 8, which has the same low bits
+    tst \count, #4
+    strne \color, [\dest], #4
+    tst \count, #2
+    strhne \color, [\dest], #2
+    tst \count, #1
+    strbne \color, [\dest]
+  4:
+    .endm
+
 @ TODO: find a way to make sure these offsets are correct
     .set o_camera_x,      0x00
     .set o_camera_y,      0x04
@@ -22,37 +144,471 @@
     .set o_camera_horizon, 0x0C
     .set o_camera_sinYaw, 0x10
     .set o_camera_cosYaw, 0x14
+    .set o_camera_yaw,    0x18
+
+@ These must match struct ZSchedule in render.h
+    .set o_schedule_farInverse, 0x00
+    .set o_schedule_slices,     0x04
+
+#ifdef RENDER_PROFILE
+
+    .set REG_TM2CNT_L, 0x04000108
+
+@ These must match enum RenderPhase and struct RenderProfile in profile.h
+    .set PHASE_OTHER,       0
+    .set PHASE_SKY,         1
+    .set PHASE_YBUFFER,     2
+    .set PHASE_SLICE_SETUP, 3
+    .set PHASE_COLUMNS,     4
+    .set PHASE_BARS,        5
+
+    .set RENDER_PROFILE_RING_SIZE, 256
+
+    .set o_profile_cycles,   0x00
+    .set o_profile_counts,   0x18
+    .set o_profile_enters,   0x30
+    .set o_profile_phase,    0x48
+    .set o_profile_lastTime, 0x4C
+    .set o_profile_ringPos,  0x50
+    .set o_profile_ring,     0x54
+
+@ Ends the current phase and starts a new one, adding count to the new phase's
+@ counter. Preserves all registers and flags.
+    .macro PROFILE_MARK phase, count=#0
+    push {r0-r3,lr}
+    mov r1, \count
+    mov r0, #\phase
+    bl profile_mark
+    pop {r0-r3,lr}
+    .endm
+
+#else
+
+    .macro PROFILE_MARK phase, count=#0
+    .endm
+
+#endif
+
+@ Compares i (r10) with the end of the columns DRAW_COLUMNS draws. Clobbers
+@ r12.
+    .macro COLUMNS_END_CHECK target
+.if \target == TARGET_STRIPS
+    ldr r12, [sp, #local_strip_end]
+    cmp r10, r12
+.else
+    cmp r10, #(SCREEN_WIDTH/2)
+.endif
+    .endm
+
+@ Draws the columns of one slice, every \step-th one from the first (see
+@ local_column_step), into frameBuffer, the span list (see local_spans) or
+@ stripBuffer (see local_strips), depending on \target. r1, r9 and r14 are
+@ set up for it by .LfoldProjection.
+    .macro DRAW_COLUMNS step, target=TARGET_FRAME
+  .LnextRun\step\target\():
+
+    @ compute the highest row any sample in this run can reach (r4)
+    add r12, sp, #local_heightmax
+    ldmia r12, {r3, r4, r11, r12}   @ r3 = corner x, r4 = corner y, r11 = x shift, r12 = x mask
+    add r3, r7, r3
+    and r3, r12, r3, asr r11        @ r3 = tile x
+    add r4, r5, r4
+    add r12, sp, #(local_heightmax + 16)
+    ldmia r12, {r11, r12}           @ r11 = y shift, r12 = y mask
+    and r4, r12, r4, asr r11        @ r4 = tile y * tiles per row
+    add r3, r3, r4
+    ldr r12, [sp, #(local_heightmax + 24)]
+    ldrb r3, [r12, r3]              @ r3 = max height
+    mla r4, r9, r3, r1
+    movs r4, r4, asr #9
+    movlt r4, #0
+
+    @ skip the run if nothing in it can rise above the y buffer
+    add r12, sp, r10, lsr #RUN_WIDTH_SHIFT  @ r12 = sp + run
+    ldrb r11, [r12, #local_run_max]
+    cmp r4, r11
+    bge .LskipRun\step\target
+    ldrb r3, [r12, #local_run_dirty]
+    cmp r3, #0
+    beq .LdrawRun\step\target
+
+    @ the run max is stale, so recompute it and try again
+    mov r3, #0
+    strb r3, [r12, #local_run_dirty]
+    add r12, sp, r10                @ r12 = &ybuffer[i]
+    RUN_MAX r11, r12, r3
+    add r12, sp, r10, lsr #RUN_WIDTH_SHIFT
+    strb r11, [r12, #local_run_max]
+    cmp r4, r11
+    bge .LskipRun\step\target
+
+  .LdrawRun\step\target\():
+    PROFILE_MARK PHASE_COLUMNS, #(RUN_WIDTH/\step)
+
+  .LnextColumn\step\target\():
+
+    @ compute map index (r3)
+    and r3, r2, r5, asr 15
+    and r4, r2, r7, asr 15
+    add r3, r4, r3, lsl 10      @ r3 = index (TERRAIN_PITCH texels per row)
+
+    @ compute height (r4)
+    ldrh r3, [r14, r3]          @ read terrain (heightmap value in upper byte, colormap value in lower byte)
+    mov r4, r3, lsr #8
+    mla r4, r9, r4, r1          @ r4 = (camera.height - heightmapBitmap[index]) * invz + (camera.horizon << 9)
+    movs r4, r4, asr #9         @ r4 = ((128 * (camera.height - heightmapBitmap[index]) * invz) >> 16) + camera.horizon;
+
+    movlt r4, #0                @ if (height < 0) height = 0
+
+    @ r12 is now free
+
+    ldrb r11, [sp, r10]
+    subs r11, r11, r4           @ r11 = ybuffer[i] - height
+    ble .LskipBar\step\target              @ only draw if ybuffer[i] > height
+
+.if \target == TARGET_SPANS
+    ldr r12, [sp, #local_span_count]
+    cmp r12, #SPAN_LIST_CAPACITY
+    beq .LspanListFull
+.endif
+
+  .LdrawBar\step\target\():
+    PROFILE_MARK PHASE_BARS, r11
+
+    @@@ Draw vertical bar from coordinate (i, height) to (i, ybuffer[i]) @@@
+
+    strb r4, [sp, r10]          @ update ybuffer[i]
+
+.if \target == TARGET_SPANS
+
+    @ add the span to the list of its top row instead
+    and r3, r3, #0xFF
+    orr r3, r3, r10, lsl #8     @ r3 = color | (i << 8)
+    add r11, sp, #local_span_heads
+    add r11, r11, r4, lsl #1    @ r11 = &local_span_heads[height]
+    ldrh r4, [r11]
+    orr r3, r3, r4, lsl #16     @ r3 |= next span << 16
+    add r12, r12, #1
+    strh r12, [r11]             @ the span is now the first of its row
+    str r12, [sp, #local_span_count]
+    ldr r11, =(spanList - 4)
+    str r3, [r11, r12, lsl #2]
+
+.elseif \target == TARGET_STRIPS
+
+    @ the columns are strips of SCREEN_HEIGHT (5 << 5) bytes
+    and r3, r3, #0xFF
+    add r12, r10, r10, lsl #2
+    add r12, r4, r12, lsl #5       @ i * SCREEN_HEIGHT + height
+    add r12, r0, r12               @ r12 = dest
+    DRAW_STRIP r3, r12, r11, r4
+
+.else
+
+    @ get color (r3)
+    and r3, r3, #0xFF
+    orr r3, r3, r3, lsl #8      @ r3 = color | (color << 8)
+
+    @ compute dest (r12)
+    rsb r12, r4, r4, lsl #4
+    add r12, r10, r12, lsl #3      @ height * (SCREEN_WIDTH/2) + i
+    add r12, r0, r12, lsl #1       @ r12 = dest
+
+    DRAW_BAR r3, r12, r11, r4
+
+.endif
+
+    @ mark the run max as stale
+    add r12, sp, r10, lsr #RUN_WIDTH_SHIFT
+    mov r11, #1
+    strb r11, [r12, #local_run_dirty]
+
+    PROFILE_MARK PHASE_COLUMNS
+
+  .LskipBar\step\target\():
+
+    add r7, r7, r6              @ lx += dx
+    add r5, r5, r8              @ ly += dy
+    add r10, r10, #\step        @ i += step
+    tst r10, #(RUN_WIDTH - 1)
+    bne .LnextColumn\step\target
+    COLUMNS_END_CHECK \target
+    blt .LnextRun\step\target
+    b .LcolumnsDone
+
+  .LskipRun\step\target\():
+    add r7, r7, r6, lsl #(RUN_WIDTH_SHIFT + 1 - \step)    @ lx += dx * RUN_WIDTH / step
+    add r5, r5, r8, lsl #(RUN_WIDTH_SHIFT + 1 - \step)    @ ly += dy * RUN_WIDTH / step
+    add r10, r10, #RUN_WIDTH                @ i += RUN_WIDTH
+    COLUMNS_END_CHECK \target
+    blt .LnextRun\step\target
+    b .LcolumnsDone
+    .endm
 
 @ Assembly-optimized renderer
     .global render_asm
 render_asm:
+    @ The stack frame holds ybuffer at sp, followed by these locals. ybuffer
+    @ has an entry per pixel in paired mode (see local_pairs) and one per
+    @ double-wide column otherwise.
+    .set local_run_max,   SCREEN_WIDTH              @ highest ybuffer value of each run (initialized along with ybuffer)
+    .set local_next_slice, (local_run_max + 16)     @ next entry of zSchedule.slices
+    .set local_run_dirty, (local_next_slice + 4)    @ nonzero if a bar was drawn in the run since local_run_max was updated
+    .set local_heightmax, (local_run_dirty + 16)    @ run bounding box corner and heightmax level for the current slice (see heightmaxLevels)
+    .set local_texels,    (local_heightmax + 28)    @ terrain mip level for the current slice (see terrainMipLevels)
+    @ per-frame parameters, in the order they are stored in
+    .set local_field,        (local_texels + 8)          @ field being drawn (0 unless interlaced)
+    .set local_column_step,  (local_field + 4)           @ 2 when interlaced
+    .set local_run_span,     (local_column_step + 4)     @ distance from the first to the last ray of a run, in half steps
+    .set local_first_column, (local_run_span + 4)        @ ybuffer index of the first column
+    .set local_columns,      (local_first_column + 4)
+    .set local_rows,         (local_columns + 4)
+    .set local_ray_spacing,  (local_rows + 4)            @ SCREEN_WIDTH / columns
+    .set local_row_scale,    (local_ray_spacing + 4)     @ RENDER_ROW_SCALE(rows)
+    .set local_horizon,      (local_row_scale + 4)       @ camera.horizon scaled to the rows
+    .set local_pairs,        (local_horizon + 4)         @ 1 in paired mode (SCREEN_WIDTH columns, see render_c)
+    .set local_column0,      (local_pairs + 4)           @ address of column 0 in frameBuffer (strip 0 in stripBuffer in column strip mode)
+    .set local_invz,         (local_column0 + 4)         @ invz of the current slice, scaled to the rows
+    @ The span list back end (see renderSpanList in render.h) adds each bar to
+    @ a list of the spans starting on its top row instead of drawing it, and
+    @ span_list_flush rasterizes the lists row by row at the end, along with
+    @ the sky. If spanList fills up first, it is rasterized there and the
+    @ rest of the frame is drawn directly.
+    .set local_spans,        (local_invz + 4)            @ SPANS_OFF, SPANS_LISTED or SPANS_FLUSHED
+    .set local_span_count,   (local_spans + 4)           @ spans in spanList
+    .set local_span_heads,   (local_span_count + 4)      @ per row: number of its first span in spanList, 0 if none
+    .set local_span_row,     (local_span_heads + 2 * SCREEN_HEIGHT)  @ row buffer of span_list_flush
+    @ Column strip mode (see renderColumnStrips in render.h) draws the columns
+    @ into stripBuffer as strips of a byte per row instead, in bands of up
+    @ to STRIP_COLUMNS from right to left, with a pass over the schedule per
+    @ band. The strips of each band are then filled with sky and transposed
+    @ into frameBuffer. Only the columns of the current band are open.
+    .set local_strips,       (local_span_row + SCREEN_WIDTH)     @ 1 in column strip mode
+    .set local_strip_first,  (local_strips + 4)          @ first column of the band
+    .set local_strip_end,    (local_strip_first + 4)     @ end of the columns of the band
+    @ With the ground plane split (see renderPlaneZ in render.h), the frame is
+    @ drawn into a window from local_plane_row down once the slices reach
+    @ local_plane_z: ybuffer, local_horizon, local_rows and local_column0 are
+    @ moved up to be relative to the window, so heights above it clamp to it.
+    .set local_plane_z,      (local_strip_end + 4)       @ z of the split, 0xFFFFFFFF when done or off
+    .set local_plane_row,    (local_plane_z + 4)         @ top of the window
+    @ With the skyline impostor (see renderSkylineZ in render.h), the slices
+    @ stop at local_skyline_z, and .LdrawSkyline projects the far field of
+    @ each column from skyline instead.
+    .set local_skyline_z,    (local_plane_row + 4)       @ 0xFFFFFFFF when off
+    .set LOCALS_SIZE,        (local_skyline_z + 4)
+
+    .set SPANS_OFF,     0
+    .set SPANS_LISTED,  1
+    .set SPANS_FLUSHED, 2
+
     push {r4-r12,lr}
-    sub sp, sp, #(SCREEN_WIDTH/2+4)
-    @ sp = ybuffer
-    @ z will be stored above this on the stack
-    .set local_saved_z, (SCREEN_WIDTH/2)
+    sub sp, sp, #LOCALS_SIZE
 
-    @@@ Fill screen with BG color @@@
+    PROFILE_MARK PHASE_YBUFFER
 
-    ldr r12, =frameBuffer
-    ldr r1, [r12]                @ r1 = dest address (frameBuffer)
-    adr r0, bgColorFillValue    @ r0 = src address
-    ldr r2, =(CPUSET_SRC_FIXED | (SCREEN_WIDTH * SCREEN_HEIGHT / 4))   @ r2 = control and size
-    swi (SWI_CPUFASTSET << 16)
+    @@@ Set up the frame @@@
+
+    mov r7, r0                  @ r7 = columns
+    mov r8, r1                  @ r8 = rows
 
-    @@@ Initialize y buffer @@@
+    @ Paired mode draws two rays per double-wide column
+    cmp r7, #SCREEN_WIDTH
+    moveq r7, #(SCREEN_WIDTH/2)
+    moveq r0, #1
+    movne r0, #0
+    str r0, [sp, #local_pairs]
 
+    @ The columns cover the same field of view at every width, and the
+    @ projection is scaled down to the rows (see render_c)
+    mov r1, r7
+    mov r0, #SCREEN_WIDTH
+    swi (SWI_DIV << 16)
+    mov r9, r0                  @ r9 = ray spacing
+    mov r0, r8, lsl #8
+    mov r1, #SCREEN_HEIGHT
+    swi (SWI_DIV << 16)
+    mov r10, r0                 @ r10 = row scale
+    ldr r2, =camera
+    ldr r11, [r2, #o_camera_horizon]
+    mul r11, r10, r11
+    asr r11, r11, #8            @ r11 = horizon
+
+    @ In interlaced mode (see renderInterlaced in render.h) only the columns
+    @ of one field are drawn, and ybuffer[i] is column i + field.
+    @ Paired mode is never interlaced.
+    ldr r0, =renderInterlaced
+    ldr r0, [r0]
+    ldr r3, [sp, #local_pairs]
+    cmp r3, #0
+    movne r0, #0
+    cmp r0, #0
+    moveq r3, #0                    @ r3 = field
+    moveq r4, #1                    @ r4 = column step
+    moveq r5, #(2 * (RUN_WIDTH - 1))    @ r5 = distance from the first to the last ray of a run, in half steps
+    ldrne r3, =renderField
+    ldrne r3, [r3]
+    movne r4, #2
+    movne r5, #(2 * (RUN_WIDTH/2 - 1))
+    ldr r0, [sp, #local_pairs]
+    cmp r0, #0
+    movne r5, #(2 * RUN_WIDTH - 1)  @ the last right ray is half a step further
+
+    @ The columns are placed at the end of ybuffer, so that they always end
+    @ with the last run, and start at the beginning of a run (r6)
+    add r6, r7, #(RUN_WIDTH - 1)
+    bic r6, r6, #(RUN_WIDTH - 1)
+    rsb r6, r6, #(SCREEN_WIDTH/2)   @ r6 = first column
+
+    add r12, sp, #local_field
+    stmia r12, {r3-r11}
+
+    @@@ Initialize y buffer and run maximums @@@
+
+    ldr r0, [sp, #local_pairs]
+    add r5, r6, r7, lsl r0      @ r5 = end of the columns (two entries per column in paired mode)
+    mov r9, #RUN_COUNT          @ r9 = end of the runs
+
+    @ Column strip mode starts with the rightmost band (see local_strips).
+    @ It draws every column, and not in pairs.
+    ldr r1, =renderColumnStrips
+    ldr r1, [r1]
+    cmp r4, #1
+    movne r1, #0
+    cmp r0, #0
+    movne r1, #0
+    str r1, [sp, #local_strips]
+    cmp r1, #0
+    beq .LopenBand
+    sub r1, r5, #(STRIP_COLUMNS - RUN_WIDTH + 1)
+    bic r1, r1, #(RUN_WIDTH - 1)
+    cmp r1, r6
+    movgt r6, r1                @ r6 = first column of the band
+
+    @ Open columns r6 to r5 and runs up to r9 with r8 rows
+  .LopenBand:
+    str r6, [sp, #local_strip_first]
+    str r5, [sp, #local_strip_end]
+
+    @ Everything else is closed
     mov r1, sp                  @ r1 = dest address (ybuffer)
-    adr r0, yBufferFillValue    @ r0 = src address
-    ldr r2, =(CPUSET_SRC_FIXED | CPUSET_32BIT | (SCREEN_WIDTH/2/4))   @ r2 = control and size
+    ldr r0, =zeroFillValue      @ r0 = src address
+    ldr r2, =(CPUSET_SRC_FIXED | CPUSET_32BIT | ((SCREEN_WIDTH+16)/4))   @ r2 = control and size
     swi (SWI_CPUSET << 16)
 
-    ldr r0, [r12]   @ r0 = frameBuffer
+    add r12, sp, r6
+    add r0, sp, r5
+  .LopenColumn:
+    strb r8, [r12], r4
+    cmp r12, r0
+    blo .LopenColumn
+    add r12, sp, #local_run_max
+    add r0, r12, r9
+    add r12, r12, r6, lsr #RUN_WIDTH_SHIFT
+  .LopenRun:
+    strb r8, [r12], #1
+    cmp r12, r0
+    blo .LopenRun
+
+    @ The span list back end only draws whole rows, so every column must be
+    @ drawn
+    ldr r0, =renderSpanList
+    ldr r0, [r0]
+    cmp r4, #1
+    movne r0, #SPANS_OFF
+    ldr r1, [sp, #local_pairs]
+    cmp r1, #0
+    movne r0, #SPANS_OFF
+    ldr r1, [sp, #local_strips]
+    cmp r1, #0
+    movne r0, #SPANS_OFF
+    cmp r0, #0
+    movne r0, #SPANS_LISTED
+    mov r1, #0
+    add r2, sp, #local_spans
+    stmia r2, {r0, r1}
+    beq .LspanListEmpty
+    add r1, sp, #local_span_heads
+    ldr r0, =zeroFillValue
+    ldr r2, =(CPUSET_SRC_FIXED | CPUSET_32BIT | (SCREEN_HEIGHT/2))
+    swi (SWI_CPUSET << 16)
+  .LspanListEmpty:
+
+    mov r0, #0
+    mov r1, #0
+    mov r2, #0
+    mov r3, #0
+    add r4, sp, #local_run_dirty
+    stmia r4, {r0-r3}
+
+    ldr r0, =frameBuffer
+    ldr r0, [r0]
+    ldr r3, [sp, #local_field]
+    sub r3, r3, r6
+    add r0, r0, r3, lsl #1      @ r0 = frameBuffer + field - first column, the address of column 0
+    ldr r1, [sp, #local_strips]
+    cmp r1, #0
+    ldrne r0, =stripBuffer
+    addne r3, r6, r6, lsl #2
+    subne r0, r0, r3, lsl #5    @ r0 = stripBuffer - first column * SCREEN_HEIGHT, the address of strip 0
+    str r0, [sp, #local_column0]
+
+    ldr r1, =renderPlaneZ
+    ldr r1, [r1]
+    cmp r1, #0
+    mvneq r1, #0
+    ldr r2, [sp, #local_spans]
+    cmp r2, #SPANS_OFF
+    mvnne r1, #0
+    ldr r2, [sp, #local_strips]
+    cmp r2, #0
+    mvnne r1, #0
+    mov r2, #0
+    add r3, sp, #local_plane_z
+    stmia r3, {r1, r2}
+    ldr r3, =renderPlaneRow
+    str r2, [r3]
+#ifdef HAVE_SKYLINE
+    ldr r1, =renderSkylineZ
+    ldr r1, [r1]
+    cmp r1, #0
+    mvneq r1, #0
+    ldr r2, [sp, #local_pairs]
+    cmp r2, #0
+    mvnne r1, #0
+    ldr r2, [sp, #local_spans]
+    cmp r2, #SPANS_OFF
+    mvnne r1, #0
+    ldr r2, [sp, #local_strips]
+    cmp r2, #0
+    mvnne r1, #0
+    ldr r2, =renderPlaneZ
+    ldr r2, [r2]
+    cmp r2, #0
+    mvnne r1, #0
+    str r1, [sp, #local_skyline_z]
+#endif
 
     @@@ Draw image
 
-    mov r1, #1          @ r1 = z
+    ldr r3, =(zSchedule + o_schedule_slices)
   .LnextZ:
+    PROFILE_MARK PHASE_SLICE_SETUP
+
+    ldmia r3!, {r1, r9}         @ r1 = z, r9 = (1 << 16) / z
+    cmp r1, #0
+    beq .LfillSky               @ end of the schedule
+    str r3, [sp, #local_next_slice]     @ store the schedule position onto the stack since it's not needed in the inner loop
+    ldr r2, [sp, #local_plane_z]
+    cmp r1, r2
+    bhs .LsplitPlane
+  .LplaneSplit:
+#ifdef HAVE_SKYLINE
+    ldr r2, [sp, #local_skyline_z]
+    cmp r1, r2
+    bhs .LdrawSkyline
+#endif
+
     ldr r2, =camera
     ldr r5, [r2, #o_camera_sinYaw]
     mul r3, r5, r1      @ r3 = camera.sinYaw * z
@@ -73,120 +629,873 @@ render_asm:
 
     @ We should really divide them by the screen width (240), but dividing them
     @ by 256 is close enough. It just ends up shrinking the FOV slightly.
-    asr r6, r6, #7      @ dx = (dx / 256) * 2
-    asr r8, r8, #7      @ dy = (dy / 256) * 2
+    ldr r3, [sp, #local_ray_spacing]
+    mul r6, r3, r6
+    asr r6, r6, #8      @ dx = (dx / 256) * ray spacing
+    mul r8, r3, r8
+    asr r8, r8, #8      @ dy = (dy / 256) * ray spacing
 
     ldr r3, [r2, #o_camera_x]
     add r7, r7, r3      @ lx += camera.x
     ldr r3, [r2, #o_camera_y]
     add r5, r5, r3      @ ly += camera.y
 
-    @ compute 1 / z in fixed point
-    ldr r9, =inverseTable
-    ldr r9, [r9, r1, lsl #2]    @ r9 = (1 << 16) / z
+    @ Pick the terrain mip level for this z (see terrain_mip_level in
+    @ render.c) and scale the ray down to its coordinates
+    mov r14, #0         @ r14 = mip level
+    cmp r1, #128
+    addhs r14, r14, #1
+    cmp r1, #256
+    addhs r14, r14, #1
+    cmp r1, #512
+    addhs r14, r14, #1
+    asr r5, r5, r14
+    asr r6, r6, r14
+    asr r7, r7, r14
+    asr r8, r8, r14
+    ldr r3, =terrainMipLevels
+    add r3, r3, r14, lsl #3
+    ldmia r3, {r3, r4}
+    add r12, sp, #local_texels
+    stmia r12, {r3, r4}
+
+    @ start at the first column of the field and step over the other one
+    add r3, sp, #local_field
+    ldmia r3, {r3, r4}  @ r3 = field, r4 = column step
+    mla r7, r6, r3, r7  @ lx += field * dx
+    mla r5, r8, r3, r5  @ ly += field * dy
+    mul r6, r4, r6      @ dx *= column step
+    mul r8, r4, r8      @ dy *= column step
+
+    @ Pick the heightmax level whose tiles are at least as wide as a run at
+    @ this z (see heightmax_level in render.c)
+    ldr r3, [sp, #local_ray_spacing]
+    mul r12, r3, r1
+    lsr r12, r12, #1    @ r12 = reach
+    ldr r11, =heightmaxLevels
+    cmp r12, #(8 << 2)
+    addhi r11, r11, #SIZEOF_LEVEL
+    cmp r12, #(8 << 3)
+    addhi r11, r11, #SIZEOF_LEVEL
+    cmp r12, #(8 << 4)
+    addhi r11, r11, #SIZEOF_LEVEL
+    cmp r12, #(8 << 5)
+    addhi r11, r11, #SIZEOF_LEVEL
+    cmp r12, #(8 << 6)
+    addhi r11, r11, #SIZEOF_LEVEL
+    cmp r12, #(8 << 7)
+    addhi r11, r11, #SIZEOF_LEVEL
+    ldmia r11, {r3, r4, r10, r11, r12}
+    sub r3, r3, r14     @ the ray is in mip level coordinates
+    sub r10, r10, r14
+    add r14, sp, #(local_heightmax + 8)
+    stmia r14, {r3, r4, r10, r11, r12}
 
-    str r1, [sp, #local_saved_z]            @ store z onto the stack since it's not needed in the inner loop
+    @ top left corner of a run's bounding box, relative to its first sample
+    ldr r4, [sp, #local_run_span]
+    mul r3, r6, r4
+    asr r3, r3, #1              @ r3 = run span * dx
+    cmp r6, #0
+    movge r3, #0
+    mul r4, r8, r4
+    asr r4, r4, #1              @ r4 = run span * dy
+    cmp r8, #0
+    movge r4, #0
+    add r14, sp, #local_heightmax
+    stmia r14, {r3, r4}
 
     ldr r14, [r2, #o_camera_height]
-    ldr r1, [r2, #o_camera_horizon]
-    
+    ldr r1, [sp, #local_horizon]
+    ldr r3, [sp, #local_row_scale]
+    mul r9, r3, r9
+    asr r9, r9, #8      @ invz, scaled to the rows
+    str r9, [sp, #local_invz]
+
     @ r2 is now free
 
     @ Draw columns
 
-    mov r10, #0         @ r10 = i
+    ldr r10, [sp, #local_first_column]  @ r10 = i
 
-    mov r2, #2048
-    sub r2, #2          @ r2 = (1024 << 1)
+    ldr r2, [sp, #(local_texels + 4)]  @ r2 = texel mask << 1
 
-  .LnextColumn:
+    PROFILE_MARK PHASE_COLUMNS
 
-    @ compute map index (r3)
-    and r3, r2, r5, asr 15
-    and r4, r2, r7, asr 15
-    add r3, r4, r3, lsl 10      @ r3 = index
+    ldr r3, [sp, #local_pairs]
+    cmp r3, #0
+    bne .LnextPairRun
 
-    @ compute height (r4)
-    ldr r12, =terrain_bin
-    ldrh r3, [r12, r3]          @ read terrain (heightmap value in upper byte, colormap value in lower byte)
-    sub r4, r14, r3, lsr #8
-    mul r12, r4, r9             @ r12 = (camera.height - heightmapBitmap[index]) * invz
-    adds r4, r1, r12, asr #9   @ r4 = ((128 * (camera.height - heightmapBitmap[index]) * invz) >> 16) + camera.horizon;
+  .LfoldProjection:
+    @ Texel heights h project to ((camera.height - h) * invz >> 9) + horizon,
+    @ which is (camera.height * invz + (horizon << 9) - h * invz) >> 9. Fold
+    @ the camera height and the horizon into one register, and keep the
+    @ texels of the mip level in the other instead of reloading them for
+    @ every column. .LcolumnsDone puts them back.
+    mul r3, r14, r9
+    add r1, r3, r1, lsl #9      @ r1 = camera.height * invz + (horizon << 9)
+    rsb r9, r9, #0              @ r9 = -invz
+    ldr r14, [sp, #local_texels]        @ r14 = texels
 
-    movlt r4, #0                @ if (height < 0) height = 0
+    ldr r3, [sp, #local_column_step]
+    cmp r3, #1
+    bne .LdrawField
+    ldr r3, [sp, #local_spans]
+    cmp r3, #SPANS_LISTED
+    beq .LlistSpans
+    ldr r3, [sp, #local_strips]
+    cmp r3, #0
+    bne .LdrawStrips
+    DRAW_COLUMNS 1
+  .LdrawField:
+    DRAW_COLUMNS 2
+  .LlistSpans:
+    DRAW_COLUMNS 1, TARGET_SPANS
 
-    @ r12 is now free
+  .LdrawStrips:
+    @ start at the first column of the band
+    ldr r3, [sp, #local_strip_first]
+    sub r4, r3, r10
+    mla r7, r6, r4, r7          @ lx += (band first - first column) * dx
+    mla r5, r8, r4, r5          @ ly += (band first - first column) * dy
+    mov r10, r3
+    DRAW_COLUMNS 1, TARGET_STRIPS
 
-    ldrb r11, [sp, r10]
-    subs r11, r11, r4           @ r11 = ybuffer[i] - height
-    ble .LskipBar               @ only draw if ybuffer[i] > height
+  .LspanListFull:
+    @ rasterize what the span list holds, and draw this bar and the rest of
+    @ the frame directly over it
+    mov r12, #SPANS_FLUSHED
+    str r12, [sp, #local_spans]
+    PROFILE_MARK PHASE_SKY
+    bl span_list_flush
+    ldr r14, [sp, #local_texels]
+    b .LdrawBar1TARGET_FRAME
 
-    @@@ Draw vertical bar from coordinate (i, height) to (i, ybuffer[i]) @@@
+    .pool
 
-    strb r4, [sp, r10]          @ update ybuffer[i]
+    @ Paired mode: each double-wide column i marches the ray of its left
+    @ pixel like the other modes and the ray of its right pixel half a step
+    @ further, with ybuffer entries 2 * i and 2 * i + 1. r0 is free here.
+  .LnextPairRun:
 
-    @ get color (r3)
-    and r3, r3, #0xFF
-    orr r3, r3, r3, lsl #8      @ r3 = color | (color << 8)
+    @ compute the highest row any sample in this run can reach (r4)
+    add r12, sp, #local_heightmax
+    ldmia r12, {r3, r4, r11, r12}   @ r3 = corner x, r4 = corner y, r11 = x shift, r12 = x mask
+    add r3, r7, r3
+    and r3, r12, r3, asr r11        @ r3 = tile x
+    add r4, r5, r4
+    add r12, sp, #(local_heightmax + 16)
+    ldmia r12, {r11, r12}           @ r11 = y shift, r12 = y mask
+    and r4, r12, r4, asr r11        @ r4 = tile y * tiles per row
+    add r3, r3, r4
+    ldr r12, [sp, #(local_heightmax + 24)]
+    ldrb r3, [r12, r3]              @ r3 = max height
+    sub r3, r14, r3
+    mul r4, r3, r9
+    adds r4, r1, r4, asr #9
+    movlt r4, #0
 
-    @ compute dest (r12)
-    rsb r12, r4, r4, lsl #4
-    add r12, r10, r12, lsl #3      @ height * (SCREEN_WIDTH/2) + i
-    add r12, r0, r12, lsl #1       @ r12 = dest
+    @ skip the run if nothing in it can rise above the y buffer
+    add r12, sp, r10, lsr #RUN_WIDTH_SHIFT  @ r12 = sp + run
+    ldrb r11, [r12, #local_run_max]
+    cmp r4, r11
+    bge .LskipPairRun
+    ldrb r3, [r12, #local_run_dirty]
+    cmp r3, #0
+    beq .LdrawPairRun
 
-.if 0
+    @ the run max is stale, so recompute it and try again
+    mov r3, #0
+    strb r3, [r12, #local_run_dirty]
+    add r12, sp, r10, lsl #1        @ r12 = &ybuffer[2 * i]
+    RUN_MAX r11, r12, r3, (2 * RUN_WIDTH)
+    add r12, sp, r10, lsr #RUN_WIDTH_SHIFT
+    strb r11, [r12, #local_run_max]
+    cmp r4, r11
+    bge .LskipPairRun
 
-  .LwriteBarPixel:
-    strh r3, [r12], #SCREEN_WIDTH
-    subs r11, #1
-    bgt .LwriteBarPixel
+  .LdrawPairRun:
+    PROFILE_MARK PHASE_COLUMNS, #(2 * RUN_WIDTH)
 
-.else
+  .LnextPair:
 
-    @ Simple "Duff's Device" to optimize this innermost loop
-    .set ITERATIONS_PER_LOOP, 16    @ must be a power of two
-    and r4, r11, #(ITERATIONS_PER_LOOP - 1)
-    rsb r4, r4, #ITERATIONS_PER_LOOP
-    add pc, pc, r4, lsl #2
-    nop
-  .LwriteBarPixel:
-    @ repeat the strh instruction ITERATIONS_PER_LOOP times
-    .rept ITERATIONS_PER_LOOP
-        strh r3, [r12], #SCREEN_WIDTH
-    .endr
-    subs r11, #ITERATIONS_PER_LOOP
-    bge .LwriteBarPixel
+    @ compute the map indices of both rays (r3, r4)
+    and r3, r2, r5, asr 15
+    and r4, r2, r7, asr 15
+    add r3, r4, r3, lsl 10          @ r3 = left index
+    add r4, r7, r6, asr #1
+    and r4, r2, r4, asr 15
+    add r11, r5, r8, asr #1
+    and r11, r2, r11, asr 15
+    add r4, r4, r11, lsl 10         @ r4 = right index
 
-.endif
+    @ compute the heights (r11, r12)
+    ldr r12, [sp, #local_texels]
+    ldrh r3, [r12, r3]              @ r3 = left texel
+    ldrh r4, [r12, r4]              @ r4 = right texel
+    sub r11, r14, r3, lsr #8
+    mul r12, r11, r9
+    adds r11, r1, r12, asr #9
+    movlt r11, #0                   @ r11 = left height
+    sub r12, r14, r4, lsr #8
+    mul r0, r12, r9
+    adds r12, r1, r0, asr #9
+    movlt r12, #0                   @ r12 = right height
+
+    @ get the colors (r3)
+    and r3, r3, #0xFF
+    and r4, r4, #0xFF
+    orr r3, r3, r4, lsl #8          @ r3 = left color | (right color << 8)
 
-  .LskipBar:
+    add r4, sp, r10, lsl #1
+    ldrb r0, [r4]                   @ r0 = left ybuffer
+    ldrb r4, [r4, #1]               @ r4 = right ybuffer
+    cmp r11, r0
+    cmpge r12, r4
+    blt .LdrawPair                  @ draw if either ray rises above its ybuffer
 
+  .LskipPair:
     add r7, r7, r6              @ lx += dx
     add r5, r5, r8              @ ly += dy
     add r10, r10, #1            @ i++
+    tst r10, #(RUN_WIDTH - 1)
+    bne .LnextPair
     cmp r10, #(SCREEN_WIDTH/2)
-    blt .LnextColumn
+    blt .LnextPairRun
+    b .LnextSlice
 
-    @ update z
-    ldr r1, [sp, #local_saved_z]
-    cmp r1, #256
-    addhs r1, r1, #4
-    cmp r1, #128
-    addhs r1, r1, #2
-    add r1, r1, #2
+  .LskipPairRun:
+    add r7, r7, r6, lsl #RUN_WIDTH_SHIFT    @ lx += dx * RUN_WIDTH
+    add r5, r5, r8, lsl #RUN_WIDTH_SHIFT    @ ly += dy * RUN_WIDTH
+    add r10, r10, #RUN_WIDTH                @ i += RUN_WIDTH
+    cmp r10, #(SCREEN_WIDTH/2)
+    blt .LnextPairRun
+    b .LnextSlice
 
-    cmp r1, #512
-    blt .LnextZ
+  .LdrawPair:
+    @@@ Draw the bars of both rays, from (r11, r0) in the left pixel and
+    @@@ (r12, r4) in the right one. r1, r2, r9 and r14 are used here and
+    @@@ reloaded afterwards.
+
+    cmp r11, r0
+    movgt r11, r0               @ r11 = left top
+    cmp r12, r4
+    movgt r12, r4               @ r12 = right top
+
+#ifdef RENDER_PROFILE
+    sub r2, r0, r11
+    add r2, r2, r4
+    sub r2, r2, r12
+    PROFILE_MARK PHASE_BARS, r2
+#endif
+
+    @ update ybuffer and mark the run max as stale
+    add r2, sp, r10, lsl #1
+    strb r11, [r2]
+    strb r12, [r2, #1]
+    add r2, sp, r10, lsr #RUN_WIDTH_SHIFT
+    mov r1, #1
+    strb r1, [r2, #local_run_dirty]
+
+    ldr r1, [sp, #local_column0]
+    add r1, r1, r10, lsl #1     @ r1 = dest of row 0
+
+    @ rows covered by both bars (r9 to r14) are written whole
+    cmp r11, r12
+    movge r9, r11
+    movlt r9, r12
+    cmp r0, r4
+    movle r14, r0
+    movgt r14, r4
+    cmp r9, r14
+    bge .LdisjointBars
+
+    @ the rows above belong to the bar that starts higher
+    subs r12, r12, r11          @ r12 = right top - left top
+    beq .LbothBars
+    blt .LrightBarAbove
+    rsb r2, r11, r11, lsl #4
+    add r2, r1, r2, lsl #4      @ r2 = dest of the left top
+    DRAW_BAR_BYTE r3, 0xFF00, r2, r12, r11
+    b .LbothBars
+  .LrightBarAbove:
+    rsb r12, r12, #0
+    sub r11, r11, r12           @ r11 = right top
+    rsb r2, r11, r11, lsl #4
+    add r2, r1, r2, lsl #4      @ r2 = dest of the right top
+    DRAW_BAR_BYTE r3, 0x00FF, r2, r12, r11
+
+  .LbothBars:
+    rsb r2, r9, r9, lsl #4
+    add r2, r1, r2, lsl #4      @ r2 = dest of row r9
+    sub r11, r14, r9
+    DRAW_BAR r3, r2, r11, r12
+
+    @ and the rows below to the bar that ends lower, from r2 on
+    subs r11, r0, r4            @ r11 = left bottom - right bottom
+    beq .LpairDrawn
+    blt .LrightBarBelow
+    DRAW_BAR_BYTE r3, 0xFF00, r2, r11, r12
+    b .LpairDrawn
+  .LrightBarBelow:
+    rsb r11, r11, #0
+    DRAW_BAR_BYTE r3, 0x00FF, r2, r11, r12
+    b .LpairDrawn
+
+  .LdisjointBars:
+    @ no row is covered by both bars, so draw each alone (either may be empty)
+    subs r0, r0, r11
+    ble .LleftBarEmpty
+    rsb r2, r11, r11, lsl #4
+    add r2, r1, r2, lsl #4
+    DRAW_BAR_BYTE r3, 0xFF00, r2, r0, r9
+  .LleftBarEmpty:
+    subs r4, r4, r12
+    ble .LpairDrawn
+    rsb r2, r12, r12, lsl #4
+    add r2, r1, r2, lsl #4
+    DRAW_BAR_BYTE r3, 0x00FF, r2, r4, r9
+
+  .LpairDrawn:
+    ldr r1, [sp, #local_horizon]
+    ldr r2, [sp, #(local_texels + 4)]
+    ldr r9, [sp, #local_invz]
+    ldr r14, =camera
+    ldr r14, [r14, #o_camera_height]
+
+    PROFILE_MARK PHASE_COLUMNS
+
+    b .LskipPair
+
+  .LcolumnsDone:
+    ldr r1, [sp, #local_horizon]
+    ldr r9, [sp, #local_invz]
+    ldr r14, =camera
+    ldr r14, [r14, #o_camera_height]
+
+  .LnextSlice:
+
+    @ Stop once every column is closed: no terrain beyond this slice can rise
+    @ above the y buffer. The peak projects highest at the far end of the
+    @ schedule when the camera is above it, and at this slice when it is below.
+    ldr r3, =terrainPeakHeight
+    ldrb r3, [r3]
+    subs r3, r14, r3            @ r3 = camera.height - terrainPeakHeight
+    ldrge r9, =zSchedule
+    ldrge r9, [r9, #o_schedule_farInverse]
+    ldrge r12, [sp, #local_row_scale]
+    mulge r9, r12, r9
+    asrge r9, r9, #8
+    mul r4, r3, r9
+    adds r4, r1, r4, asr #9
+    movlt r4, #0                @ r4 = highest row the peak can reach
+
+    mov r10, #0                 @ r10 = run
+  .LcheckRun:
+    add r12, sp, r10
+    ldrb r11, [r12, #local_run_max]
+    cmp r11, r4
+    bls .LrunClosed
+    ldrb r3, [r12, #local_run_dirty]
+    cmp r3, #0
+    beq .LnotDone
+
+    @ the run max is stale, so recompute it and check again
+    mov r3, #0
+    strb r3, [r12, #local_run_dirty]
+    ldr r3, [sp, #local_pairs]
+    cmp r3, #0
+    bne .LcheckPairRun
+    add r12, sp, r10, lsl #RUN_WIDTH_SHIFT
+    RUN_MAX r11, r12, r3
+    b .LrunChecked
+  .LcheckPairRun:
+    add r12, sp, r10, lsl #(RUN_WIDTH_SHIFT + 1)
+    RUN_MAX r11, r12, r3, (2 * RUN_WIDTH)
+  .LrunChecked:
+    add r12, sp, r10
+    strb r11, [r12, #local_run_max]
+    cmp r11, r4
+    bhi .LnotDone
+  .LrunClosed:
+    add r10, r10, #1
+    cmp r10, #RUN_COUNT
+    blt .LcheckRun
+    b .LfillSky
+
+  .LnotDone:
+
+    ldr r3, [sp, #local_next_slice]
+    b .LnextZ
+
+  .LfillSky:
+    PROFILE_MARK PHASE_SKY
+
+    @ The span list back end draws the sky along with the spans
+    ldr r3, [sp, #local_spans]
+    cmp r3, #SPANS_LISTED
+    bleq span_list_flush
+    cmp r3, #SPANS_OFF
+    bne .Lreturn
+    ldr r3, [sp, #local_strips]
+    cmp r3, #0
+    bne .LfinishBand
+
+    @@@ Fill the sky above the terrain @@@
+
+    @ The back buffer is not cleared, so every pixel above ybuffer[i] must
+    @ be written here. Terrain covers most of the screen in most views, so
+    @ this writes far less than a full-screen clear would.
+
+    @ find the top of the terrain across all columns, the lowest ybuffer value (r4)
+    ldr r0, [sp, #local_column0]
+    ldr r4, [sp, #local_rows]
+    ldr r10, [sp, #local_first_column]
+    ldr r6, [sp, #local_column_step]
+    ldr r7, [sp, #local_pairs]
+    mov r8, #(SCREEN_WIDTH/2)
+    mov r8, r8, lsl r7          @ r8 = end of ybuffer
+  .LfindSkyBottom:
+    ldrb r3, [sp, r10]
+    cmp r3, r4
+    movlo r4, r3
+    add r10, r10, r6
+    cmp r10, r8
+    blt .LfindSkyBottom
+
+    @ Rows above that are sky in every column, so fill them with CpuFastSet.
+    @ It works in blocks of 8 words, so round down to an even row count.
+    bics r4, r4, #1
+    beq .LfillSkyColumns
+    mov r5, r0
+    ldr r1, =frameBuffer
+    ldr r1, [r1]
+    ldr r2, [sp, #local_plane_row]
+    rsb r2, r2, r2, lsl #4
+    add r1, r1, r2, lsl #4      @ r1 = dest address (the top of the window in frameBuffer)
+    ldr r0, =bgColorFillValue   @ r0 = src address
+    mov r2, #(SCREEN_WIDTH/4)
+    mul r2, r4, r2
+    orr r2, r2, #CPUSET_SRC_FIXED   @ r2 = control and size
+    swi (SWI_CPUFASTSET << 16)
+    mov r0, r5
+
+  .LfillSkyColumns:
+    @ then fill the rest of each column down to ybuffer[i]
+    ldr r3, =(BG_COLOR | (BG_COLOR << 8))
+    rsb r5, r4, r4, lsl #4
+    add r5, r0, r5, lsl #4      @ r5 = dest of the first column (row r4)
+    mov r10, #0
+    cmp r7, #0
+    bne .LnextSkyPair
+  .LnextSkyColumn:
+    ldrb r11, [sp, r10]
+    subs r11, r11, r4           @ r11 = ybuffer[i] - first row
+    ble .LskipSkyColumn
+    add r12, r5, r10, lsl #1    @ r12 = dest
+    DRAW_BAR r3, r12, r11, r6
+  .LskipSkyColumn:
+    add r10, r10, #1
+    cmp r10, #(SCREEN_WIDTH/2)
+    blt .LnextSkyColumn
+    b .Lreturn
+
+    @ In paired mode, down to the higher of the two ybuffer entries of the
+    @ column whole, and on down to the lower one in its pixel alone
+  .LnextSkyPair:
+    add r12, sp, r10, lsl #1
+    ldrb r7, [r12]              @ r7 = left ybuffer
+    ldrb r8, [r12, #1]          @ r8 = right ybuffer
+    add r12, r5, r10, lsl #1    @ r12 = dest
+    cmp r7, r8
+    movlo r11, r7
+    movhs r11, r8
+    subs r11, r11, r4
+    ble .LskySingleBar
+    DRAW_BAR r3, r12, r11, r6
+  .LskySingleBar:
+    subs r11, r7, r8            @ r11 = left ybuffer - right ybuffer
+    beq .LskipSkyPair
+    blt .LskyRightBar
+    DRAW_BAR_BYTE r3, 0xFF00, r12, r11, r6
+    b .LskipSkyPair
+  .LskyRightBar:
+    rsb r11, r11, #0
+    DRAW_BAR_BYTE r3, 0x00FF, r12, r11, r6
+  .LskipSkyPair:
+    add r10, r10, #1
+    cmp r10, #(SCREEN_WIDTH/2)
+    blt .LnextSkyPair
 
   .Lreturn:
+    PROFILE_MARK PHASE_OTHER
+
     @ return
-    add sp, sp, #(SCREEN_WIDTH/2+4)
+    add sp, sp, #LOCALS_SIZE
     pop {r4-r12,lr}
     bx lr
 
+  .LsplitPlane:
+    @ Leave the rows above the terrain drawn so far to the ground plane (r4),
+    @ the top of the open columns
+    mvn r2, #0
+    str r2, [sp, #local_plane_z]
+    ldr r10, [sp, #local_first_column]
+    ldr r6, [sp, #local_column_step]
+    ldr r8, [sp, #local_strip_end]
+    ldr r4, [sp, #local_rows]
+  .LfindPlaneRow:
+    ldrb r2, [sp, r10]
+    cmp r2, r4
+    movlo r4, r2
+    add r10, r10, r6
+    cmp r10, r8
+    blt .LfindPlaneRow
+    cmp r4, #0
+    beq .LplaneSplit
+    str r4, [sp, #local_plane_row]
+    ldr r2, =renderPlaneRow
+    str r4, [r2]
+
+    @ and move everything up to the window
+    ldr r10, [sp, #local_first_column]
+  .LmoveYBuffer:
+    ldrb r2, [sp, r10]
+    sub r2, r2, r4
+    strb r2, [sp, r10]
+    add r10, r10, r6
+    cmp r10, r8
+    blt .LmoveYBuffer
+    mov r2, #1
+    orr r2, r2, r2, lsl #8
+    orr r2, r2, r2, lsl #16
+    add r10, sp, #local_run_dirty
+    str r2, [r10]               @ recompute every run max
+    str r2, [r10, #4]
+    str r2, [r10, #8]
+    str r2, [r10, #12]
+    ldr r2, [sp, #local_horizon]
+    sub r2, r2, r4
+    str r2, [sp, #local_horizon]
+    ldr r2, [sp, #local_rows]
+    sub r2, r2, r4
+    str r2, [sp, #local_rows]
+    rsb r4, r4, r4, lsl #4
+    ldr r0, [sp, #local_column0]    @ (paired mode uses r0 in the loop)
+    add r0, r0, r4, lsl #4      @ r0 += window top * SCREEN_WIDTH
+    str r0, [sp, #local_column0]
+    b .LplaneSplit
+
+#ifdef HAVE_SKYLINE
+  .LdrawSkyline:
+    @ Project the far field of each column from the samples of its direction
+    @ in skyline (see render_c), and fill the sky above it
+    PROFILE_MARK PHASE_SKY
+    ldr r2, =camera
+    ldr r14, [r2, #o_camera_height]
+    ldrh r12, [r2, #o_camera_yaw]
+    bic r12, r12, #0xFF         @ r12 = yaw of the view (fixed_sin steps in 256 yaw units)
+    ldr r1, [sp, #local_horizon]
+    ldr r10, [sp, #local_first_column]  @ r10 = i
+    ldr r3, [sp, #local_field]
+    sub r9, r3, r10             @ r9 = field - first column (ybuffer[i] is column i + r9)
+  .LnextSkylineColumn:
+    ldrb r7, [sp, r10]          @ r7 = ybuffer[i]
+    cmp r7, #0
+    beq .LskipSkylineColumn
+    add r3, r10, r9
+    ldr r4, [sp, #local_ray_spacing]
+    mul r3, r4, r3
+    ldr r4, =skylineRays
+    ldr r3, [r4, r3, lsl #2]    @ r3 = ray yaw | secant << 16
+    add r4, r3, r12
+    mov r4, r4, lsl #16
+    mov r4, r4, lsr #(16 + SKYLINE_DIRECTION_SHIFT)     @ r4 = direction
+    ldr r5, =skyline
+    add r5, r5, r4, lsl #SKYLINE_DIRECTION_SIZE_SHIFT
+    ldr r6, [r5], #4            @ r6 = spans left, r5 = span
+    mov r3, r3, lsr #16
+    ldr r4, [sp, #local_row_scale]
+    mul r3, r4, r3
+    mov r3, r3, lsr #8          @ r3 = secant scaled to the rows
+    ldr r0, [sp, #local_column0]
+    add r8, r0, r10, lsl #1     @ r8 = address of the column
+  .LnextSkylineSpan:
+    subs r6, r6, #1
+    blt .LskylineColumnDone
+    ldr r4, [r5], #4            @ r4 = height | color << 8 | inverse << 16
+    mov r11, r4, lsr #16
+    mul r11, r3, r11
+    mov r11, r11, lsr #8        @ r11 = invz, scaled to the rows and the column
+    and r2, r4, #0xFF
+    sub r2, r14, r2
+    mul r2, r11, r2
+    adds r2, r1, r2, asr #9     @ r2 = height
+    movlt r2, #0
+    subs r11, r7, r2            @ r11 = ybuffer[i] - height
+    ble .LnextSkylineSpan
+    mov r7, r2
+    and r4, r4, #0xFF00
+    orr r4, r4, r4, lsr #8      @ r4 = color | (color << 8)
+    rsb r2, r2, r2, lsl #4
+    add r2, r8, r2, lsl #4      @ r2 = dest
+    DRAW_BAR r4, r2, r11, r0
+    b .LnextSkylineSpan
+  .LskylineColumnDone:
+    strb r7, [sp, r10]
+  .LskipSkylineColumn:
+    ldr r3, [sp, #local_column_step]
+    add r10, r10, r3
+    cmp r10, #(SCREEN_WIDTH/2)
+    blt .LnextSkylineColumn
+    b .LfillSky
+#endif
+
+    .pool
+
+  .LfinishBand:
+    @ fill each strip of the band with sky down to ybuffer[i]
+    ldr r0, [sp, #local_column0]
+    ldr r10, [sp, #local_strip_first]
+    ldr r9, [sp, #local_strip_end]
+    ldr r7, =(BG_COLOR * 0x01010101)
+  .LnextSkyStrip:
+    ldrb r11, [sp, r10]
+    cmp r11, #0
+    beq .LskipSkyStrip
+    add r12, r10, r10, lsl #2
+    add r12, r0, r12, lsl #5    @ r12 = dest
+    mov r3, r7
+    DRAW_STRIP r3, r12, r11, r4
+  .LskipSkyStrip:
+    add r10, r10, #1
+    cmp r10, r9
+    blt .LnextSkyStrip
+
+    @ Transpose the band into frameBuffer, four rows of two strips at a time.
+    @ The rows are rounded up to a multiple of four; the extra rows are
+    @ never shown.
+    ldr r14, =frameBuffer
+    ldr r14, [r14]
+    ldr r3, [sp, #local_first_column]
+    sub r14, r14, r3, lsl #1    @ r14 = address of column 0 in frameBuffer
+    ldr r8, [sp, #local_rows]
+    add r8, r8, #3
+    mov r8, r8, lsr #2          @ r8 = blocks of four rows
+    ldr r12, =0x00FF00FF
+    mov r11, #0xFF000000
+    orr r11, r11, #0x00FF0000   @ r11 = 0xFFFF0000
+    ldr r10, [sp, #local_strip_first]
+  .LtransposePair:
+    add r1, r10, r10, lsl #2
+    add r1, r0, r1, lsl #5      @ r1 = left strip
+    add r7, r14, r10, lsl #1    @ r7 = dest
+    mov r9, r8
+  .LtransposeBlock:
+    ldr r2, [r1, #SCREEN_HEIGHT]    @ r2 = rows 3 2 1 0 of the right strip
+    ldr r3, [r1], #4                @ r3 = rows 3 2 1 0 of the left strip
+    and r4, r12, r3
+    orr r4, r4, r4, lsl #8      @ r4 = left pixels of rows 2 and 0, doubled
+    and r5, r12, r2
+    orr r5, r5, r5, lsl #8      @ r5 = right pixels of rows 2 and 0, doubled
+    bic r6, r4, r11
+    orr r6, r6, r5, lsl #16
+    str r6, [r7]                @ row 0
+    and r5, r5, r11
+    orr r5, r5, r4, lsr #16
+    str r5, [r7, #(2 * SCREEN_WIDTH)]   @ row 2
+    and r4, r12, r3, lsr #8
+    orr r4, r4, r4, lsl #8      @ r4 = left pixels of rows 3 and 1, doubled
+    and r5, r12, r2, lsr #8
+    orr r5, r5, r5, lsl #8      @ r5 = right pixels of rows 3 and 1, doubled
+    bic r6, r4, r11
+    orr r6, r6, r5, lsl #16
+    str r6, [r7, #SCREEN_WIDTH] @ row 1
+    and r5, r5, r11
+    orr r5, r5, r4, lsr #16
+    str r5, [r7, #(3 * SCREEN_WIDTH)]   @ row 3
+    add r7, r7, #(4 * SCREEN_WIDTH)
+    subs r9, r9, #1
+    bne .LtransposeBlock
+    add r10, r10, #2
+    ldr r3, [sp, #local_strip_end]
+    cmp r10, r3
+    blt .LtransposePair
+
+    @ then draw the next band to the left, if any
+    ldr r5, [sp, #local_strip_first]    @ r5 = end of the band
+    ldr r6, [sp, #local_first_column]
+    cmp r5, r6
+    beq .Lreturn
+    PROFILE_MARK PHASE_YBUFFER
+    mov r9, r5, lsr #RUN_WIDTH_SHIFT
+    sub r1, r5, #(STRIP_COLUMNS - RUN_WIDTH + 1)
+    bic r1, r1, #(RUN_WIDTH - 1)
+    cmp r1, r6
+    movgt r6, r1                @ r6 = first column of the band
+    mov r4, #1
+    ldr r8, [sp, #local_rows]
+    b .LopenBand
+
 bgColorFillValue:
     .fill 4, 1, BG_COLOR
-yBufferFillValue:
-    .fill 4, 1, SCREEN_HEIGHT
+zeroFillValue:
+    .word 0
+
+@ Per level of heightmax_bin (HEIGHTMAX_MIN_LEVEL to HEIGHTMAX_MAX_LEVEL in
+@ render.h): x shift, x mask, y shift, y mask, level data.
+@ The masks wrap tile coordinates around the map like the texel coordinates.
+@ The y shift and mask leave the tile row multiplied by the tiles per row.
+    .set heightmax_offset, 0
+heightmaxLevels:
+    .irp level, 2, 3, 4, 5, 6, 7, 8
+        .word 16 + \level
+        .word (1024 >> \level) - 1
+        .word 6 + 2 * \level
+        .word ((1024 >> \level) - 1) << (10 - \level)
+        .word heightmax_bin + heightmax_offset
+        .set heightmax_offset, heightmax_offset + (1024 >> \level) * (1024 >> \level)
+    .endr
+
+@ Per terrain mip level (0 is the full map, see TERRAIN_MIP_LEVELS in
+@ render.h): level data, texel mask << 1
+terrainMipLevels:
+    .word terrain_bin
+    .word (TERRAIN_PITCH - 1) << 1
+    .irp level, 1, 2, 3
+        .word terrainmip_bin + (TERRAIN_PITCH - (2 * TERRAIN_PITCH >> \level)) * 2
+        .word ((TERRAIN_PITCH >> \level) - 1) << 1
+    .endr
+
+    .pool
+
+@ Rasterizes the span list (see local_spans) into the rows and columns being
+@ drawn, top to bottom. A row buffer carries the color of each column down
+@ from the row above: the spans starting on a row are applied to it, and
+@ then the row is copied to frameBuffer with ldmia/stmia. The row buffer
+@ starts out as the sky. Called from render_asm, whose locals are just
+@ above the registers this saves.
+span_list_flush:
+    push {r0-r12, lr}
+    .set SPAN_FLUSH_SAVED, (14 * 4)
+
+    add r0, sp, #(SPAN_FLUSH_SAVED + local_span_row)    @ r0 = row buffer
+    ldr r10, [sp, #(SPAN_FLUSH_SAVED + local_first_column)]
+    add r10, r0, r10, lsl #1        @ r10 = first column in the row buffer
+    ldr lr, [sp, #(SPAN_FLUSH_SAVED + local_columns)]
+    add lr, r10, lr, lsl #1         @ lr = end of the columns in the row buffer
+    ldr r3, bgColorFillValue
+    mov r1, r10
+  .LclearSpanRow:
+    str r3, [r1], #4
+    cmp r1, lr
+    blo .LclearSpanRow
+
+    add r8, sp, #(SPAN_FLUSH_SAVED + local_span_heads)  @ r8 = row heads
+    ldr r9, =(spanList - 4)         @ r9 = spans, by number
+    ldr r11, =frameBuffer
+    ldr r11, [r11]                  @ r11 = dest
+    ldr r12, [sp, #(SPAN_FLUSH_SAVED + local_rows)]    @ r12 = rows left
+  .LnextSpanRow:
+    ldrh r3, [r8], #2
+    cmp r3, #0
+    beq .LcopySpanRow
+  .LnextSpan:
+    ldr r4, [r9, r3, lsl #2]        @ r4 = color | (column << 8) | (next span << 16)
+    and r5, r4, #0xFF
+    orr r5, r5, r5, lsl #8
+    and r6, r4, #0xFF00
+    add r6, r0, r6, lsr #7
+    strh r5, [r6]                   @ row[column] = color | (color << 8)
+    movs r3, r4, lsr #16
+    bne .LnextSpan
+  .LcopySpanRow:
+    @ the rows are a whole number of 5-word blocks at every resolution
+    mov r1, r10
+    mov r2, r11
+  .LcopySpanBlock:
+    ldmia r1!, {r3-r7}
+    stmia r2!, {r3-r7}
+    cmp r1, lr
+    blo .LcopySpanBlock
+    add r11, r11, #SCREEN_WIDTH
+    subs r12, r12, #1
+    bne .LnextSpanRow
+
+    pop {r0-r12, lr}
+    bx lr
 
     .pool
+
+@ Copies the columns of one field from one page to another
+@ r0 = dest, r1 = src, r2 = field
+    .global copy_field_asm
+copy_field_asm:
+    add r0, r0, r2, lsl #1
+    add r1, r1, r2, lsl #1
+    @ the field is every other halfword of the page
+    .set COPY_FIELD_UNROLL, 16
+    mov r2, #(SCREEN_WIDTH/4 * SCREEN_HEIGHT / COPY_FIELD_UNROLL)
+  1:
+    .rept COPY_FIELD_UNROLL
+        ldrh r3, [r1], #4
+        strh r3, [r0], #4
+    .endr
+    subs r2, r2, #1
+    bne 1b
+    bx lr
+
+#ifdef RENDER_PROFILE
+
+@ r0 = new phase, r1 = amount to add to the new phase's counter
+profile_mark:
+    push {r4, r5}
+    ldr r2, =renderProfile
+
+    @ count work for the new phase
+    add r5, r2, r0, lsl #2
+    ldr r4, [r5, #o_profile_counts]
+    add r4, r4, r1
+    str r4, [r5, #o_profile_counts]
+    ldr r4, [r5, #o_profile_enters]
+    add r4, r4, #1
+    str r4, [r5, #o_profile_enters]
+
+    @ charge the time since the last mark to the current phase
+    ldr r3, =REG_TM2CNT_L
+    ldrh r3, [r3]                   @ r3 = now (low 16 bits of the stopwatch)
+    ldr r4, [r2, #o_profile_lastTime]
+    str r3, [r2, #o_profile_lastTime]
+    sub r4, r3, r4
+    mov r4, r4, lsl #16
+    mov r4, r4, lsr #16             @ r4 = cycles since the last mark
+    ldr r5, [r2, #o_profile_phase]
+    str r0, [r2, #o_profile_phase]
+    add r5, r2, r5, lsl #2
+    ldr r1, [r5, #o_profile_cycles]
+    add r1, r1, r4
+    str r1, [r5, #o_profile_cycles]
+
+    @ record the mark in the ring buffer
+    ldr r5, [r2, #o_profile_ringPos]
+    orr r3, r3, r0, lsl #16
+    add r1, r2, #o_profile_ring
+    str r3, [r1, r5, lsl #2]
+    add r5, r5, #1
+    and r5, r5, #(RENDER_PROFILE_RING_SIZE - 1)
+    str r5, [r2, #o_profile_ringPos]
+
+    pop {r4, r5}
+    bx lr
+
+    .pool
+
+#endif
+
+@ Scratch memory of render_asm: the span list (see local_spans), with
+@ entries of color | (column << 8) | (number of the next span on the same
+@ row << 16), or the strips of a band in column strip mode (see local_strips)
+    .bss
+    .align 2
+spanList:
+stripBuffer:
+    .space (STRIP_COLUMNS * SCREEN_HEIGHT)
@@ -0,0 +1,174 @@
+#include <gba_base.h>
+#include <gba_input.h>
+#include <gba_video.h>
+#include <stddef.h>
+
+#include "debug.h"
+#include "render.h"
+#include "replay.h"
+
+#include "flight_bin.h"
+
+#if defined(INPUT_RECORD) || defined(INPUT_REPLAY)
+
+// The debug log uses the rest of SRAM (see debug.c)
+#define SRAM_RECORDING ((vu8 *)0x0E006000)
+#define SRAM_RECORDING_SIZE 0x2000
+#define MAX_RUNS ((SRAM_RECORDING_SIZE - sizeof(struct InputRecordingHeader)) / sizeof(struct InputRun))
+
+// SRAM is on an 8-bit bus, so it must be accessed one byte at a time
+static void sram_write(u32 offset, const void *src, u32 size)
+{
+    const u8 *bytes = src;
+    u32 i;
+
+    for (i = 0; i < size; i++)
+        SRAM_RECORDING[offset + i] = bytes[i];
+}
+
+static void sram_read(u32 offset, void *dest, u32 size)
+{
+    u8 *bytes = dest;
+    u32 i;
+
+    for (i = 0; i < size; i++)
+        bytes[i] = SRAM_RECORDING[offset + i];
+}
+
+static u32 run_offset(u32 run)
+{
+    return sizeof(struct InputRecordingHeader) + run * sizeof(struct InputRun);
+}
+
+#endif
+
+#ifdef INPUT_RECORD
+
+static struct InputRecordingHeader sHeader;
+static struct InputRun sRun;
+
+void record_init(void)
+{
+    sHeader.magic = INPUT_RECORDING_MAGIC;
+    sHeader.runCount = 0;
+    sram_write(0, &sHeader, sizeof(sHeader));
+}
+
+// Appends the keys held this frame to the recording. The header and the
+// current run are rewritten every frame so that the recording is complete
+// whenever the emulator saves.
+void record_keys(u16 keys)
+{
+    if (sHeader.runCount != 0 && sRun.keys == keys && sRun.frames != 0xFFFF)
+    {
+        sRun.frames++;
+    }
+    else
+    {
+        if (sHeader.runCount == MAX_RUNS)
+            return;  // SRAM is full
+        sRun.keys = keys;
+        sRun.frames = 1;
+        sHeader.runCount++;
+        sram_write(0, &sHeader, sizeof(sHeader));
+    }
+    sram_write(run_offset(sHeader.runCount - 1), &sRun, sizeof(sRun));
+}
+
+#endif // INPUT_RECORD
+
+#ifdef INPUT_REPLAY
+
+static struct InputRecordingHeader sHeader;
+static const struct InputRun *sRomRuns;  // NULL when replaying from SRAM
+static struct InputRun sRun;
+static u32 sNextRun;
+static u32 sFrame;
+static int sDone;
+
+static u32 sCrcTable[256];
+
+static void crc32_init(void)
+{
+    u32 i, crc;
+    int j;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        sCrcTable[i] = crc;
+    }
+}
+
+// Same CRC as the host golden-image tests, so frames can be compared with
+// render_c output on the host
+static u32 crc32(const void *data, u32 size)
+{
+    const u8 *p = data;
+    u32 crc = 0xFFFFFFFF;
+    u32 i;
+
+    for (i = 0; i < size; i++)
+        crc = (crc >> 8) ^ sCrcTable[(crc ^ p[i]) & 0xFF];
+    return ~crc;
+}
+
+void replay_init(void)
+{
+    crc32_init();
+    sram_read(0, &sHeader, sizeof(sHeader));
+    if (sHeader.magic == INPUT_RECORDING_MAGIC && sHeader.runCount <= MAX_RUNS)
+    {
+        sRomRuns = NULL;
+        debug_printf("# replaying %lu runs from SRAM", sHeader.runCount);
+    }
+    else
+    {
+        sHeader = *(const struct InputRecordingHeader *)flight_bin;
+        sRomRuns = (const struct InputRun *)(flight_bin + sizeof(sHeader));
+        debug_printf("# replaying %lu runs from flight.bin", sHeader.runCount);
+    }
+    debug_printf("frame,crc,renderTime");
+    sRun.frames = 0;
+    sNextRun = 0;
+    sFrame = 0;
+    sDone = 0;
+}
+
+// Returns the keys held on the next frame of the stream
+u16 replay_next_keys(void)
+{
+    while (sRun.frames == 0)
+    {
+        if (sNextRun == sHeader.runCount)
+        {
+            if (!sDone)
+            {
+                debug_printf("# done");
+                sDone = 1;
+            }
+            return ~REG_KEYINPUT;
+        }
+        if (sRomRuns != NULL)
+            sRun = sRomRuns[sNextRun];
+        else
+            sram_read(run_offset(sNextRun), &sRun, sizeof(sRun));
+        sNextRun++;
+    }
+    sRun.frames--;
+    return sRun.keys;
+}
+
+// Logs the CRC of the frame presented for this step of the stream, with a
+// render time of 0 if it was not rendered because the camera did not move
+void replay_log_frame(const u16 *frame, u32 renderTime)
+{
+    if (sDone)
+        return;
+    debug_printf("%lu,0x%08lX,%lu", sFrame, crc32(frame, SCREEN_WIDTH * SCREEN_HEIGHT), renderTime);
+    sFrame++;
+}
+
+#endif // INPUT_REPLAY
@@ -0,0 +1,45 @@
+#ifndef GUARD_REPLAY_H
+#define GUARD_REPLAY_H
+
+// Deterministic input record/replay for reproducible performance runs.
+//
+// Building with -DINPUT_RECORD (make record) logs the keys held on every
+// frame to the top of SRAM as run-length encoded {keys, frames} pairs, so
+// the .sav file of a play session holds the flight. Building with
+// -DINPUT_REPLAY (make replay) feeds update() from the recording in SRAM, or
+// from replay/flight.bin when SRAM holds none, and writes the CRC of the
+// frame presented on every step and its render time through the debug log.
+// Once the stream runs out, input comes from the keypad again.
+//
+// tools/extract_replay.py turns a .sav file into a replay/flight.bin.
+
+#include <gba_base.h>
+
+// The layout of these structs is the format of the stream in SRAM and in
+// replay/flight.bin (little endian)
+struct InputRecordingHeader
+{
+    /*0x00*/ u32 magic;
+    /*0x04*/ u32 runCount;
+};
+
+struct InputRun
+{
+    /*0x00*/ u16 keys;
+    /*0x02*/ u16 frames;
+};
+
+#define INPUT_RECORDING_MAGIC 0x5359454B  // "KEYS"
+
+#ifdef INPUT_RECORD
+void record_init(void);
+void record_keys(u16 keys);
+#endif
+
+#ifdef INPUT_REPLAY
+void replay_init(void);
+u16 replay_next_keys(void);
+void replay_log_frame(const u16 *frame, u32 renderTime);
+#endif
+
+#endif // GUARD_REPLAY_H
@@ -0,0 +1,97 @@
+#include <gba_base.h>
+#include <gba_interrupt.h>
+#include <gba_timers.h>
+#include <string.h>
+
+#include "debug.h"
+#include "sampler.h"
+
+#ifdef PC_SAMPLER
+
+#define BIOS_SIZE   0x4000
+#define IWRAM_SIZE  0x8000
+#define ROM_CODE_SIZE 0x40000  // only the start of ROM holds code
+
+#define BIOS_SHIFT  6
+#define IWRAM_SHIFT 4
+#define ROM_SHIFT   5
+
+static EWRAM_BSS u32 sBiosCounts[BIOS_SIZE >> BIOS_SHIFT];
+static EWRAM_BSS u32 sIwramCounts[IWRAM_SIZE >> IWRAM_SHIFT];
+static EWRAM_BSS u32 sRomCounts[ROM_CODE_SIZE >> ROM_SHIFT];
+
+const struct SampleRegion sampleRegions[] =
+{
+    {0x00000000, BIOS_SIZE,     BIOS_SHIFT,  sBiosCounts},
+    {0x03000000, IWRAM_SIZE,    IWRAM_SHIFT, sIwramCounts},
+    {0x08000000, ROM_CODE_SIZE, ROM_SHIFT,   sRomCounts},
+};
+const u32 sampleRegionCount = sizeof(sampleRegions) / sizeof(sampleRegions[0]);
+
+// samples that fell outside every region
+u32 sampleMisses;
+
+extern void sampler_irq(void);
+
+#define TM_ENABLE (1 << 7)
+#define TM_IRQ (1 << 6)
+#define TM_FREQ_64 1
+
+static void sampler_clear(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < sampleRegionCount; i++)
+        memset(sampleRegions[i].counts, 0, (sampleRegions[i].size >> sampleRegions[i].shift) * sizeof(u32));
+    sampleMisses = 0;
+}
+
+void sampler_start(void)
+{
+    u32 period = PC_SAMPLER_PERIOD;
+    u16 control = TM_ENABLE | TM_IRQ;
+
+    sampler_clear();
+
+    // Long periods use the 64 cycle prescaler
+    if (period > 0x10000)
+    {
+        period /= 64;
+        control |= TM_FREQ_64;
+    }
+
+    // sampler_irq replaces the libgba dispatcher so that it can read the
+    // interrupted PC from the frame the BIOS pushed
+    REG_IME = 0;
+    INT_VECTOR = sampler_irq;
+    REG_TM1CNT_H = 0;
+    REG_TM1CNT_L = 0x10000 - period;
+    REG_TM1CNT_H = control;
+    REG_IE |= IRQ_TIMER1;
+    REG_IME = 1;
+}
+
+// Writes every nonzero bucket as "pc,<bucket address>,<samples>" and clears
+// the histogram
+void sampler_dump(void)
+{
+    unsigned int i, j;
+
+    REG_IME = 0;
+    debug_printf("# pc samples, period %i cycles", PC_SAMPLER_PERIOD);
+    for (i = 0; i < sampleRegionCount; i++)
+    {
+        const struct SampleRegion *region = &sampleRegions[i];
+
+        for (j = 0; j < (region->size >> region->shift); j++)
+        {
+            if (region->counts[j] != 0)
+                debug_printf("pc,0x%08lX,%lu", region->start + (j << region->shift), region->counts[j]);
+        }
+    }
+    debug_printf("pc,other,%lu", sampleMisses);
+    sampler_clear();
+    REG_IME = 1;
+}
+
+#endif // PC_SAMPLER
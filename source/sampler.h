@@ -0,0 +1,32 @@
+#ifndef GUARD_SAMPLER_H
+#define GUARD_SAMPLER_H
+
+// Statistical PC-sampling profiler, enabled by building with -DPC_SAMPLER
+// (make sampler). Timer 1 interrupts the program every PC_SAMPLER_PERIOD
+// cycles and the interrupted PC is counted in a histogram bucketed by
+// address. sampler_dump() writes the histogram through the debug log, and
+// tools/pc_histogram.py maps it back to symbols using the linker map.
+
+#ifdef PC_SAMPLER
+
+#include <gba_base.h>
+
+#ifndef PC_SAMPLER_PERIOD
+#define PC_SAMPLER_PERIOD 2003  // cycles between samples (prime to avoid aliasing with loops)
+#endif
+
+// The layout of this struct must match the o_region_* offsets in sampler.s
+struct SampleRegion
+{
+    /*0x00*/ u32 start;
+    /*0x04*/ u32 size;
+    /*0x08*/ u32 shift;   // log2 of the bucket size in bytes
+    /*0x0C*/ u32 *counts;
+};
+
+void sampler_start(void);
+void sampler_dump(void);
+
+#endif // PC_SAMPLER
+
+#endif // GUARD_SAMPLER_H
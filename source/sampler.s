@@ -0,0 +1,65 @@
+    .syntax unified
+    .arm
+
+#ifdef PC_SAMPLER
+
+    .section .iwram,"ax",%progbits
+
+    .set REG_IF, 0x04000202
+    .set BIOS_IF, 0x03007FF8
+    .set IRQ_TIMER1, (1 << 4)
+
+@ These must match struct SampleRegion in sampler.h
+    .set o_region_start,  0x00
+    .set o_region_size,   0x04
+    .set o_region_shift,  0x08
+    .set o_region_counts, 0x0C
+    .set SIZEOF_REGION,   0x10
+
+@ Timer 1 interrupt handler, called by the BIOS in IRQ mode after it has
+@ pushed {r0-r3, r12, lr}. lr was saved as the interrupted PC + 4.
+    .global sampler_irq
+sampler_irq:
+    @ acknowledge the interrupt
+    ldr r0, =REG_IF
+    mov r1, #IRQ_TIMER1
+    strh r1, [r0]
+    ldr r0, =BIOS_IF
+    ldrh r2, [r0]
+    orr r2, r2, r1
+    strh r2, [r0]
+
+    ldr r0, [sp, #20]
+    sub r0, r0, #4              @ r0 = interrupted PC
+
+    ldr r1, =sampleRegions
+    ldr r2, =sampleRegionCount
+    ldr r2, [r2]                @ r2 = regions left
+  .LnextRegion:
+    ldr r3, [r1, #o_region_start]
+    sub r3, r0, r3              @ r3 = offset into region
+    ldr r12, [r1, #o_region_size]
+    cmp r3, r12
+    blo .LfoundRegion
+    add r1, r1, #SIZEOF_REGION
+    subs r2, r2, #1
+    bne .LnextRegion
+
+    ldr r1, =sampleMisses
+    ldr r2, [r1]
+    add r2, r2, #1
+    str r2, [r1]
+    bx lr
+
+  .LfoundRegion:
+    ldr r12, [r1, #o_region_shift]
+    mov r3, r3, lsr r12         @ r3 = bucket
+    ldr r1, [r1, #o_region_counts]
+    ldr r2, [r1, r3, lsl #2]
+    add r2, r2, #1
+    str r2, [r1, r3, lsl #2]
+    bx lr
+
+    .pool
+
+#endif
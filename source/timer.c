@@ -0,0 +1,26 @@
+#include <gba_timers.h>
+
+#include "timer.h"
+
+#define TM_ENABLE (1 << 7)
+#define TM_CASCADE (1 << 2)
+
+void start_timer(void)
+{
+    // Disable timers and make them count from zero
+    REG_TM3CNT = 0;
+    REG_TM2CNT = 0;
+
+    // start timers
+    REG_TM3CNT_H = TM_ENABLE | TM_CASCADE;
+    REG_TM2CNT_H = TM_ENABLE;
+}
+
+u32 stop_timer(void)
+{
+    u32 time = (REG_TM3CNT_L << 16) | REG_TM2CNT_L;
+
+    REG_TM3CNT = 0;
+    REG_TM2CNT = 0;
+    return time;
+}
@@ -0,0 +1,10 @@
+#ifndef GUARD_TIMER_H
+#define GUARD_TIMER_H
+
+#include <gba_base.h>
+
+// Cycle-accurate stopwatch built from the cascaded TM2/TM3 timer pair
+void start_timer(void);
+u32 stop_timer(void);
+
+#endif // GUARD_TIMER_H
@@ -0,0 +1,13 @@
+#ifndef GUARD_TRIG_H
+#define GUARD_TRIG_H
+
+#include <gba_base.h>
+
+// represents a signed Q16.16 fixed point number
+typedef s32 fixed_t;
+
+fixed_t float_to_fixed(float n);
+fixed_t fixed_sin(int angle);
+fixed_t fixed_cos(int angle);
+
+#endif // GUARD_TRIG_H
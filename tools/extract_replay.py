@@ -0,0 +1,46 @@
+#!/usr/bin/env python
+#
+# Copies the input recording made by the record ROM (make record) out of its
+# save file, so it can be embedded as replay/flight.bin
+#
+# Compatible with Python 2 and Python 3
+#
+
+import struct
+import sys
+
+# Must match SRAM_RECORDING and struct InputRecordingHeader in replay.c/replay.h
+RECORDING_OFFSET = 0x6000
+RECORDING_MAGIC = 0x5359454B
+HEADER_SIZE = 8
+RUN_SIZE = 4
+
+def fatal(message):
+    print(message)
+    exit(1)
+
+if len(sys.argv) != 3:
+     fatal('usage: ' + sys.argv[0] + ' savefile binfile')
+
+with open(sys.argv[1], 'rb') as f:
+    save = f.read()
+
+header = save[RECORDING_OFFSET:RECORDING_OFFSET + HEADER_SIZE]
+if len(header) != HEADER_SIZE:
+    fatal(sys.argv[1] + ': too small to hold a recording')
+(magic, runCount) = struct.unpack('<II', header)
+if magic != RECORDING_MAGIC:
+    fatal(sys.argv[1] + ': no input recording found')
+
+end = RECORDING_OFFSET + HEADER_SIZE + runCount * RUN_SIZE
+if end > len(save):
+    fatal(sys.argv[1] + ': recording is truncated')
+
+frames = 0
+for i in range(runCount):
+    (keys, count) = struct.unpack_from('<HH', save, RECORDING_OFFSET + HEADER_SIZE + i * RUN_SIZE)
+    frames += count
+
+with open(sys.argv[2], 'wb') as f:
+    f.write(save[RECORDING_OFFSET:end])
+print('%s: %i runs, %i frames' % (sys.argv[2], runCount, frames))
@@ -1,6 +1,9 @@
 #!/usr/bin/env python
 #
-# Interleaves a colormap image and heightmap image into a terrain map
+# Interleaves a colormap image and heightmap image into a terrain map, and
+# optionally writes the max-height pyramid used for empty-space skipping, the
+# prefiltered mip levels sampled by far slices, and the RGB555 colors of the
+# map and its mip levels for the Mode 5 renderer
 #
 # Compatible with Python 2 and Python 3
 #
@@ -15,8 +18,71 @@ def fatal(message):
     print(message)
     exit(1)
 
-if len(sys.argv) != 4:
-     fatal('usage: ' + sys.argv[0] + ' colormap heightmap binfile')
+# Must match HEIGHTMAX_MIN_LEVEL and HEIGHTMAX_MAX_LEVEL in render.h
+HEIGHTMAX_MIN_LEVEL = 2
+HEIGHTMAX_MAX_LEVEL = 8
+
+# Must match TERRAIN_MIP_LEVELS and TERRAIN_PITCH in render.h
+TERRAIN_MIP_LEVELS = 3
+TERRAIN_PITCH = 1024
+
+# Returns the next level of a max-height pyramid: the highest point of each
+# 2x2 block of the level below
+def half_max(level, width, height):
+    result = []
+    for y in range(0, height, 2):
+        row0 = level[y * width:(y + 1) * width]
+        row1 = level[(y + 1) * width:(y + 2) * width]
+        for x in range(0, width, 2):
+            result.append(max(row0[x], row0[x + 1], row1[x], row1[x + 1]))
+    return result
+
+# Each tile of the written pyramid holds the highest point of itself and of
+# the tiles to its right, below and below-right (wrapping around like the
+# renderer does), so a lookup at the top-left corner of any box no bigger
+# than a tile covers the whole box
+def dilate(level, width, height):
+    result = []
+    for y in range(0, height):
+        y1 = (y + 1) % height
+        for x in range(0, width):
+            x1 = (x + 1) % width
+            result.append(max(level[y * width + x], level[y * width + x1],
+                              level[y1 * width + x], level[y1 * width + x1]))
+    return result
+
+# Returns the sums of each 2x2 block of a level of sums
+def half_sum(level, width, height):
+    result = []
+    for y in range(0, height, 2):
+        row0 = level[y * width:(y + 1) * width]
+        row1 = level[(y + 1) * width:(y + 2) * width]
+        for x in range(0, width, 2):
+            result.append(row0[x] + row0[x + 1] + row1[x] + row1[x + 1])
+    return result
+
+# Returns the index of the palette entry closest to an RGB color, compared at
+# the 5 bits per channel the GBA displays
+nearestCache = {}
+def nearest_color(palette, r, g, b):
+    key = ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)
+    if key not in nearestCache:
+        best = None
+        for i in range(0, len(palette)):
+            pr, pg, pb = palette[i][0:3]
+            d = ((pr >> 3) - (r >> 3)) ** 2 + ((pg >> 3) - (g >> 3)) ** 2 + ((pb >> 3) - (b >> 3)) ** 2
+            if best is None or d < bestDistance:
+                best = i
+                bestDistance = d
+        nearestCache[key] = best
+    return nearestCache[key]
+
+# Returns the RGB555 color the GBA displays for an RGB color
+def rgb555(r, g, b):
+    return (r >> 3) | ((g >> 3) << 5) | ((b >> 3) << 10)
+
+if len(sys.argv) < 4 or len(sys.argv) > 7:
+     fatal('usage: ' + sys.argv[0] + ' colormap heightmap binfile [heightmaxfile [mipfile [rgb555file]]]')
 
 # Read colormap
 r = png.Reader(sys.argv[1])
@@ -27,7 +93,8 @@ if not is_pow_of_2(cmapHeight):
     fatal(sys.argv[1] + ': height must be a power of two')
 if info['bitdepth'] != 8:
     fatal(sys.argv[1] + ': bit depth must be 8')
-    
+palette = info.get('palette')
+
 # Read heightmap
 r = png.Reader(sys.argv[2])
 (hmapWidth, hmapHeight, hmapRows, info) = r.read()
@@ -43,13 +110,83 @@ if info['bitdepth'] != 8:
 if hmapWidth != cmapWidth or hmapHeight != cmapHeight:
     fatal('heightmap and colormap must have the same dimensions')
 
+heights = []
+colors = []
 with open(sys.argv[3], 'wb') as f:
     for y in range(0, hmapHeight):
         hmapRow = next(hmapRows)
         cmapRow = next(cmapRows)
+        heights.extend(hmapRow)
+        colors.extend(cmapRow)
         for x in range(0, hmapWidth):
             f.write(bytearray([cmapRow[x], hmapRow[x]]))
             #f.write(cmapRow[x])
             #sys.stdout.write('0x%02X, 0x%02X, ' % (int(hmapRow[x]), int(cmapRow[x])))
         #sys.stdout.write('\n')
 
+if len(sys.argv) >= 5:
+    if hmapWidth < (1 << HEIGHTMAX_MAX_LEVEL) or hmapHeight < (1 << HEIGHTMAX_MAX_LEVEL):
+        fatal(sys.argv[2] + ': too small for the height pyramid')
+    level = heights
+    width = hmapWidth
+    height = hmapHeight
+    with open(sys.argv[4], 'wb') as f:
+        for i in range(1, HEIGHTMAX_MAX_LEVEL + 1):
+            level = half_max(level, width, height)
+            width //= 2
+            height //= 2
+            if i >= HEIGHTMAX_MIN_LEVEL:
+                f.write(bytearray(dilate(level, width, height)))
+
+# The mip levels average 2^L x 2^L blocks of texels: the heights directly and
+# the colors in RGB, mapped back to the closest palette entry. Level L is
+# stored at column TERRAIN_PITCH - (2 * TERRAIN_PITCH >> L) of rows of
+# TERRAIN_PITCH texels, so the renderer indexes every level like the full map.
+if len(sys.argv) >= 6:
+    if palette is None:
+        fatal(sys.argv[1] + ': the mip levels need a paletted colormap')
+    if hmapWidth != TERRAIN_PITCH or hmapHeight != TERRAIN_PITCH:
+        fatal(sys.argv[2] + ': the mip levels need a ' + str(TERRAIN_PITCH) + 'x' + str(TERRAIN_PITCH) + ' map')
+    mip = bytearray(TERRAIN_PITCH * (hmapHeight // 2) * 2)
+    heightSums = heights
+    channelSums = [[palette[c][k] for c in colors] for k in range(0, 3)]
+    # RGB555 colors of the mip levels, laid out like them
+    mip555 = bytearray(TERRAIN_PITCH * (hmapHeight // 2) * 2)
+    width = hmapWidth
+    height = hmapHeight
+    for level in range(1, TERRAIN_MIP_LEVELS + 1):
+        heightSums = half_sum(heightSums, width, height)
+        channelSums = [half_sum(sums, width, height) for sums in channelSums]
+        width //= 2
+        height //= 2
+        shift = 2 * level
+        half = 1 << (shift - 1)
+        column = TERRAIN_PITCH - (2 * TERRAIN_PITCH >> level)
+        for y in range(0, height):
+            offset = (y * TERRAIN_PITCH + column) * 2
+            for x in range(0, width):
+                i = y * width + x
+                r = (channelSums[0][i] + half) >> shift
+                g = (channelSums[1][i] + half) >> shift
+                b = (channelSums[2][i] + half) >> shift
+                mip[offset + x * 2] = nearest_color(palette, r, g, b)
+                mip[offset + x * 2 + 1] = (heightSums[i] + half) >> shift
+                color = rgb555(r, g, b)
+                mip555[offset + x * 2] = color & 0xFF
+                mip555[offset + x * 2 + 1] = color >> 8
+    with open(sys.argv[5], 'wb') as f:
+        f.write(mip)
+
+# The RGB555 colors of the full map, followed by those of the mip levels.
+# They have the same layout as terrain.bin and terrainmip.bin, so the Mode 5
+# renderer reads a texel's color at the offset of its height.
+if len(sys.argv) == 7:
+    palette555 = [rgb555(*palette[i][0:3]) for i in range(0, len(palette))]
+    with open(sys.argv[6], 'wb') as f:
+        full = bytearray(len(colors) * 2)
+        for i in range(0, len(colors)):
+            color = palette555[colors[i]]
+            full[i * 2] = color & 0xFF
+            full[i * 2 + 1] = color >> 8
+        f.write(full)
+        f.write(mip555)
@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+#
+# Maps the PC sample histogram written by the sampler ROM (make sampler) to
+# the symbols in its linker map and prints where the time went
+#
+# The log is the mGBA debug log or the text read back from the save file;
+# only lines of the form "pc,<address>,<samples>" are used. Static functions
+# do not appear in the map, so their samples are attributed to the global
+# symbol before them.
+#
+# Compatible with Python 2 and Python 3
+#
+
+import bisect
+import re
+import sys
+
+def fatal(message):
+    print(message)
+    exit(1)
+
+if len(sys.argv) != 3:
+     fatal('usage: ' + sys.argv[0] + ' mapfile logfile')
+
+# Symbol lines look like "                0x08000238                update" and
+# input section lines like " .text          0x08000238      0x1c8 main.o"
+symbolLine = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$')
+sectionLine = re.compile(r'^\s*(\.[\w.]+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)\s*$')
+
+symbols = {}
+sections = {}
+with open(sys.argv[1]) as f:
+    for line in f:
+        m = symbolLine.match(line)
+        if m:
+            address = int(m.group(1), 16)
+            # keep the first name given to an address
+            if address != 0:
+                symbols.setdefault(address, m.group(2))
+            continue
+        m = sectionLine.match(line)
+        if m and int(m.group(3), 16) != 0:
+            address = int(m.group(2), 16)
+            objectName = m.group(4).split('/')[-1]
+            sections.setdefault(address, '(' + objectName + ')')
+
+# input sections name the code between them and their first global symbol
+for address in sections:
+    symbols.setdefault(address, sections[address])
+
+addresses = sorted(symbols)
+
+def region_name(address):
+    if address < 0x4000:
+        return 'BIOS'
+    if 0x03000000 <= address < 0x03008000:
+        return 'IWRAM'
+    if 0x08000000 <= address < 0x0A000000:
+        return 'ROM'
+    return 'other'
+
+def symbol_name(address):
+    if address < 0x4000:
+        return '(BIOS)'
+    i = bisect.bisect_right(addresses, address) - 1
+    if i < 0 or region_name(addresses[i]) != region_name(address):
+        return '(unknown)'
+    return symbols[addresses[i]]
+
+totals = {}
+regionTotals = {}
+total = 0
+with open(sys.argv[2]) as f:
+    for line in f:
+        line = line.strip()
+        # mGBA prefixes each line with its log level
+        start = line.find('pc,')
+        if start < 0:
+            continue
+        fields = line[start:].split(',')
+        if len(fields) != 3:
+            continue
+        count = int(fields[2])
+        if fields[1] == 'other':
+            name = '(outside sampled regions)'
+            region = 'other'
+        else:
+            address = int(fields[1], 16)
+            name = symbol_name(address)
+            region = region_name(address)
+        totals[name] = totals.get(name, 0) + count
+        regionTotals[region] = regionTotals.get(region, 0) + count
+        total += count
+
+if total == 0:
+    fatal(sys.argv[2] + ': no samples found')
+
+print('%8s %7s  %s' % ('samples', 'percent', 'region'))
+for region in sorted(regionTotals, key=lambda r: -regionTotals[r]):
+    print('%8i %6.2f%%  %s' % (regionTotals[region], 100.0 * regionTotals[region] / total, region))
+print('')
+print('%8s %7s  %s' % ('samples', 'percent', 'symbol'))
+for name in sorted(totals, key=lambda n: -totals[n]):
+    print('%8i %6.2f%%  %s' % (totals[name], 100.0 * totals[name] / total, name))